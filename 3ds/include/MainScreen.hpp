@@ -34,6 +34,7 @@
 #include "YesNoOverlay.hpp"
 #include "clickable.hpp"
 #include "gui.hpp"
+#include "job.hpp"
 #include "multiselection.hpp"
 #include "scrollable.hpp"
 #include "thread.hpp"
@@ -57,6 +58,8 @@ protected:
     void updateSelector(void);
     void updateButtons(void);
     std::string nameFromCell(size_t index) const;
+    void startBackup(size_t cellIndex);
+    void startRestore(size_t cellIndex);
 
 private:
     Hid<HidDirection::HORIZONTAL, HidDirection::VERTICAL> hid;
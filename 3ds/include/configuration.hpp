@@ -49,6 +49,10 @@ public:
     bool favorite(u64 id);
     bool nandSaves(void);
     bool shouldScanCard(void);
+    // store only the files that changed since the previous backup, see io::backup
+    bool incrementalBackups(void);
+    // write new backups as a single compressed file, see bundle.hpp
+    bool bundledBackups(void);
     std::vector<std::u16string> additionalSaveFolders(u64 id);
     std::vector<std::u16string> additionalExtdataFolders(u64 id);
 
@@ -67,6 +71,8 @@ private:
     std::unordered_set<u64> mFilterIds, mFavoriteIds;
     std::unordered_map<u64, std::vector<std::u16string>> mAdditionalSaveFolders, mAdditionalExtdataFolders;
     bool mNandSaves, mScanCard;
+    bool mIncrementalBackups = false;
+    bool mBundledBackups     = false;
     std::string BASEPATH = "/3ds/Checkpoint/config.json";
     size_t oldSize       = 0;
 };
@@ -39,12 +39,22 @@ public:
 
     Result error(void);
     std::u16string entry(size_t index);
+    u64 fileSize(size_t index);
     bool folder(size_t index);
     bool good(void);
     size_t size(void);
 
 private:
-    std::vector<FS_DirectoryEntry> mList;
+    // names live back to back in mNames, entries only keep what callers ask for
+    struct Entry {
+        u32 offset;
+        u16 length;
+        u32 attributes;
+        u64 fileSize;
+    };
+
+    std::vector<Entry> mList;
+    std::u16string mNames;
     Result mError;
     bool mGood;
 };
@@ -37,7 +37,11 @@ public:
     ~FSStream() = default;
 
     Result close(void);
+    // Opt-in: stop flushing every write. With interval == 0 data is flushed once on close,
+    // otherwise whenever at least interval bytes have been written since the last flush.
+    void deferFlush(u32 interval = 0);
     bool eof(void);
+    Result flush(void);
     bool good(void);
     void offset(u32 o);
     u32 offset(void);
@@ -52,6 +56,9 @@ private:
     u32 mOffset;
     Result mResult;
     bool mGood;
+    bool mDeferFlush;
+    u32 mFlushInterval;
+    u32 mUnflushed;
 };
 
 #endif
\ No newline at end of file
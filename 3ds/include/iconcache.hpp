@@ -0,0 +1,49 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef ICONCACHE_HPP
+#define ICONCACHE_HPP
+
+#include <3ds.h>
+#include <citro2d.h>
+#include <string>
+#include <unordered_map>
+
+// Title icons are decoded the first time they are drawn instead of when the titles are loaded. Decoded
+// icons live in a fixed number of textures that are recycled least recently drawn first, so neither
+// startup time nor linear memory grows with the size of the library.
+namespace IconCache {
+    // Offsets of the raw icon data in the title cache file, by title id. Titles that aren't in there have
+    // their SMDH read instead. Called from the loader thread whenever the cache file is rewritten.
+    void setSource(const std::u16string& path, std::unordered_map<u64, u32> offsets);
+    // Raw 48x48 icon data of a title, from the title cache file if it is in there. Any thread.
+    bool read(u64 id, FS_MediaType media, u16* dst);
+    // Main thread only.
+    C2D_Image get(u64 id, FS_MediaType media);
+    void exit(void);
+}
+
+#endif
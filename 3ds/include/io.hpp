@@ -40,12 +40,36 @@
 #define BUFFER_SIZE 0x50000
 
 namespace io {
-    std::tuple<bool, Result, std::string> backup(size_t index, size_t cellIndex);
+    struct ManifestEntry {
+        std::u16string path; // relative to the manifest root
+        u64 size;
+        bool directory;
+        std::u16string origin = {}; // folder to read the file from instead of the source root, if set
+    };
+
+    // Flat listing of a tree, parents before their children, gathered in a single walk so
+    // progress totals and the copy itself don't need to traverse the tree again.
+    struct Manifest {
+        std::vector<ManifestEntry> entries;
+        size_t files = 0;
+        u64 bytes    = 0;
+    };
+
+    // Resolves the destination folder name for a backup, prompting the user through the software
+    // keyboard when a new folder is being created. Must be called from the UI thread.
+    std::u16string backupName(size_t cellIndex);
+    std::tuple<bool, Result, std::string> backup(size_t index, size_t cellIndex, const std::u16string& customPath);
     std::tuple<bool, Result, std::string> restore(size_t index, size_t cellIndex, const std::string& nameFromCell);
 
-    size_t countFiles(FS_Archive arch, const std::u16string& path);
+    Result buildManifest(FS_Archive arch, const std::u16string& root, Manifest& manifest);
     Result copyDirectory(FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath);
-    void copyFile(FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath);
+    Result copyManifest(
+        const Manifest& manifest, FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath);
+    // Makes dstPath match the manifest of srcPath, writing only the files that differ and deleting the
+    // ones the manifest doesn't list.
+    Result syncManifest(
+        const Manifest& manifest, FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath);
+    Result copyFile(FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath, u64* hash = nullptr);
     Result createDirectory(FS_Archive archive, const std::u16string& path);
     void deleteBackupFolder(const std::u16string& path);
     Result deleteFolderRecursively(FS_Archive arch, const std::u16string& path);
@@ -46,8 +46,12 @@ namespace TitleLoader {
 
     bool validId(u64 id);
     bool scanCard(void);
-    void exportTitleListCache(std::vector<Title>& list, const std::u16string& path);
-    void importTitleListCache(void);
+    // returns how many icons came from the titles themselves instead of being read again
+    size_t exportTitleListCache(
+        std::vector<Title>& titles, const std::vector<size_t>& saves, const std::vector<size_t>& extdatas, const std::vector<u64>& known);
+    // false when the cache is missing, of another version or corrupted, the titles need a rescan then. known
+    // receives the ids of every installed title the cache has seen
+    bool importTitleListCache(std::vector<u64>& known);
 }
 
 #endif // LOADER_HPP
\ No newline at end of file
@@ -32,21 +32,28 @@
 #include <atomic>
 #include <citro2d.h>
 #include <memory>
+#include <mutex>
 #include <vector>
 
-inline std::shared_ptr<Screen> g_screen = nullptr;
-inline bool g_bottomScrollEnabled       = false;
-inline float g_timer                    = 0;
+inline std::shared_ptr<Screen> g_screen        = nullptr;
+inline bool g_bottomScrollEnabled              = false;
+inline float g_timer                           = 0;
 inline std::string g_selectedCheatKey;
 inline std::vector<std::string> g_selectedCheatCodes;
-inline std::atomic<bool> g_isLoadingTitles = false;
-inline int g_loadingTitlesCounter          = 0;
-inline int g_loadingTitlesLimit            = 0;
+inline std::atomic<bool> g_isLoadingTitles     = false;
+inline std::atomic<int> g_loadingTitlesCounter = 0;
+inline int g_loadingTitlesLimit                = 0;
 
+// transfer progress, written by the job thread and read by the UI at its own frame rate
+inline std::atomic<bool> g_isTransferringFile = false;
+inline std::atomic<size_t> g_copyCount        = 0;
+inline std::atomic<size_t> g_copyTotal        = 0;
+inline std::atomic<u64> g_copyBytes           = 0;
+inline std::atomic<u64> g_copyBytesTotal      = 0;
+inline std::atomic<u64> g_copyStartTime       = 0; // ms
+// guards g_currentFile and g_transferMode
+inline std::mutex g_transferMutex;
 inline std::u16string g_currentFile;
-inline bool g_isTransferringFile = false;
-inline size_t g_copyCount        = 0;
-inline size_t g_copyTotal        = 0;
 inline std::string g_transferMode;
 
 #endif
\ No newline at end of file
@@ -65,5 +65,8 @@ typedef struct {
 
 smdh_s* loadSMDH(u32 low, u32 high, u8 media);
 smdh_s* loadSMDH(const std::string& path);
+// Time spent inside loadSMDH so far, in microseconds, summed over every thread that called it; with parallel
+// workers this exceeds the wall-clock time of the scan
+u64 smdhReadTime(void);
 
 #endif
\ No newline at end of file
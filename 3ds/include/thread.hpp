@@ -52,6 +52,8 @@ namespace Threads {
     bool create(void (*entrypoint)(void*), void* arg = nullptr, std::optional<size_t> stackSize = std::nullopt);
     // Executes task on a worker thread with stack size of 0x8000 (if settable).
     void executeTask(void (*task)(void*), void* arg);
+    // Most worker threads executeTask will spin up at once
+    u8 workerLimit(void);
 
     namespace internal {
         template <typename EPFunc, typename... Args>
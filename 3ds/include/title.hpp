@@ -38,6 +38,7 @@
 #include "util.hpp"
 #include <algorithm>
 #include <citro2d.h>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -60,12 +61,15 @@ public:
     std::u16string fullExtdataPath(size_t index);
     u32 highId(void);
     C2D_Image icon(void);
+    // Raw icon from the SMDH read by load(), kept until the title cache has been written. nullptr otherwise
+    const u16* iconData(void);
+    void releaseIconData(void);
     u64 id(void);
     bool isActivityLog(void);
     void load(void);
     bool load(u64 id, FS_MediaType mediaType, FS_CardType cardType);
     void load(u64 id, u8* productCode, bool accessibleSave, bool accessibleExtdata, std::u16string shortDescription, std::u16string longDescription,
-        std::u16string savePath, std::u16string extdataPath, FS_MediaType media, FS_CardType cardType, CardType card);
+        std::u16string savePath, FS_MediaType media, FS_CardType cardType, CardType card);
     std::string longDescription(void);
     std::u16string getLongDescription(void);
     u32 lowId(void);
@@ -84,24 +88,30 @@ public:
     char productCode[16];
 
 private:
+    std::u16string folder(void);
+    void setStrings(const std::u16string& shortDescription, const std::u16string& longDescription, const std::u16string& folder);
+    std::u16string string(size_t begin, size_t end);
+
     bool mAccessibleSave;
     bool mAccessibleExtdata;
-    std::u16string mShortDescription;
-    std::u16string mLongDescription;
-    std::u16string mSavePath;
-    std::u16string mExtdataPath;
+    // short description | long description | backup folder name, in one buffer shared by every copy of the title
+    std::shared_ptr<const std::u16string> mStrings;
+    u16 mLongOffset;
+    u16 mFolderOffset;
 
+    // backup names are kept once, along with the folder they live in: 0 for the title's own folder, i + 1 for the i-th additional one
     std::vector<std::u16string> mSaves;
-    std::vector<std::u16string> mFullSavePaths;
+    std::vector<u16> mSaveFolders;
+    std::vector<std::u16string> mAdditionalSaveFolders;
     std::vector<std::u16string> mExtdata;
-    std::vector<std::u16string> mFullExtdataPaths;
+    std::vector<u16> mExtdataFolders;
+    std::vector<std::u16string> mAdditionalExtdataFolders;
     u64 mId;
     FS_MediaType mMedia;
     FS_CardType mCard;
     CardType mCardType;
     C2D_Image mIcon;
+    std::shared_ptr<u16[]> mIconData;
 };
 
-C2D_Image loadTextureFromBytes(u16* bigIconData);
-
 #endif
\ No newline at end of file
@@ -43,7 +43,6 @@ extern "C" {
 }
 
 Result consoleDisplayError(const std::string& message, Result res);
-void calculateTitleDBHash(u8* hash);
 Result servicesInit(void);
 
 namespace StringUtils {
@@ -202,8 +202,12 @@ void MainScreen::drawTop(void) const
         if (g_isTransferringFile) {
             C2D_DrawRectSolid(0, 0, 0.5f, 400, 240, COLOR_OVERLAY);
 
-            const float size    = 0.7f;
-            std::string modeStr = (g_transferMode.empty() ? "Copying files" : g_transferMode) + " in progress...";
+            const float size = 0.7f;
+            std::string modeStr;
+            {
+                std::lock_guard<std::mutex> lock(g_transferMutex);
+                modeStr = (g_transferMode.empty() ? "Copying files" : g_transferMode) + " in progress...";
+            }
             C2D_Text modeText;
             C2D_TextParse(&modeText, dynamicBuf, modeStr.c_str());
             C2D_TextOptimize(&modeText);
@@ -291,8 +295,16 @@ void MainScreen::drawBottom(void) const
         C2D_DrawRectSolid(mx, my, 0.5f, mw, mh, COLOR_BLACK_DARKERR);
         Gui::drawOutline(mx, my, mw, mh, 2, COLOR_PURPLE_LIGHT);
 
+        std::string titleStr, fname;
+        {
+            std::lock_guard<std::mutex> lock(g_transferMutex);
+            titleStr = (g_transferMode.empty() ? "Copying files" : g_transferMode) + " in progress...";
+            fname    = StringUtils::UTF16toUTF8(g_currentFile);
+        }
+        const size_t copyCount = g_copyCount, copyTotal = g_copyTotal;
+        const u64 copyBytes = g_copyBytes, copyBytesTotal = g_copyBytesTotal;
+
         // Title
-        std::string titleStr = (g_transferMode.empty() ? "Copying files" : g_transferMode) + " in progress...";
         C2D_Text titleText;
         C2D_TextParse(&titleText, dynamicBuf, titleStr.c_str());
         C2D_TextOptimize(&titleText);
@@ -300,7 +312,6 @@ void MainScreen::drawBottom(void) const
             &titleText, C2D_WithColor, ceilf(mx + (mw - StringUtils::textWidth(titleText, 0.55f)) / 2), my + 10, 0.5f, 0.55f, 0.55f, COLOR_WHITE);
 
         // Current filename
-        std::string fname = StringUtils::UTF16toUTF8(g_currentFile);
         C2D_Text fileText;
         C2D_TextParse(&fileText, dynamicBuf, fname.c_str());
         C2D_TextOptimize(&fileText);
@@ -311,7 +322,7 @@ void MainScreen::drawBottom(void) const
         const int barX = mx + 12, barY = my + 65, barW = mw - 24, barH = 12;
         C2D_DrawRectSolid(barX, barY, 0.5f, barW, barH, COLOR_BLACK_MEDIUM);
 
-        float progress = (g_copyTotal > 0) ? (float)g_copyCount / (float)g_copyTotal : 0.0f;
+        float progress = copyBytesTotal > 0 ? (float)copyBytes / (float)copyBytesTotal : copyTotal > 0 ? (float)copyCount / (float)copyTotal : 0.0f;
         if (progress > 1.0f)
             progress = 1.0f;
         int fillW = (int)(barW * progress);
@@ -322,7 +333,7 @@ void MainScreen::drawBottom(void) const
 
         // Count (left) and percentage (right) below bar
         char countStr[24];
-        snprintf(countStr, sizeof(countStr), "%zu / %zu", g_copyCount, g_copyTotal);
+        snprintf(countStr, sizeof(countStr), "%zu / %zu", copyCount, copyTotal);
         C2D_Text countText;
         C2D_TextParse(&countText, dynamicBuf, countStr);
         C2D_TextOptimize(&countText);
@@ -335,15 +346,58 @@ void MainScreen::drawBottom(void) const
         C2D_TextOptimize(&pctText);
         C2D_DrawText(
             &pctText, C2D_WithColor, barX + barW - ceilf(StringUtils::textWidth(pctText, 0.45f)), barY + barH + 4, 0.5f, 0.45f, 0.45f, COLOR_WHITE);
+
+        std::string eta = DateTime::etaStr(copyBytes, copyBytesTotal, osGetTime() - g_copyStartTime);
+        if (!eta.empty()) {
+            C2D_Text etaText;
+            C2D_TextParse(&etaText, dynamicBuf, eta.c_str());
+            C2D_TextOptimize(&etaText);
+            C2D_DrawText(&etaText, C2D_WithColor, ceilf(barX + (barW - StringUtils::textWidth(etaText, 0.45f)) / 2), barY + barH + 4, 0.5f, 0.45f,
+                0.45f, COLOR_GREY_LIGHT);
+        }
     }
 }
 
 void MainScreen::update(const InputState& input)
 {
+    // input stays locked while a backup or restore runs in the background
+    if (Job::running()) {
+        return;
+    }
+
+    if (auto outcome = Job::collect()) {
+        if (std::get<0>(*outcome)) {
+            currentOverlay = std::make_shared<InfoOverlay>(*this, std::get<2>(*outcome));
+        }
+        else {
+            currentOverlay = std::make_shared<ErrorOverlay>(*this, std::get<1>(*outcome), std::get<2>(*outcome));
+        }
+        // the job finished without any input, its result has to show up right away
+        invalidate();
+        return;
+    }
+
     updateSelector();
     handleEvents(input);
 }
 
+void MainScreen::startBackup(size_t cellIndex)
+{
+    const size_t titleIndex = hid.fullIndex();
+    // the keyboard has to be shown from the UI thread, before the job starts
+    std::u16string customPath = io::backupName(cellIndex);
+
+    Job::start([titleIndex, cellIndex, customPath]() { return io::backup(titleIndex, cellIndex, customPath); });
+}
+
+void MainScreen::startRestore(size_t cellIndex)
+{
+    const size_t titleIndex = hid.fullIndex();
+    const std::string name  = nameFromCell(cellIndex);
+
+    Job::start([titleIndex, cellIndex, name]() { return io::restore(titleIndex, cellIndex, name); });
+}
+
 void MainScreen::updateSelector(void)
 {
     if (g_isLoadingTitles) {
@@ -379,13 +433,8 @@ void MainScreen::handleEvents(const InputState& input)
                 currentOverlay = std::make_shared<YesNoOverlay>(
                     *this, "Backup selected title?",
                     [this]() {
-                        auto result = io::backup(hid.fullIndex(), 0);
-                        if (std::get<0>(result)) {
-                            currentOverlay = std::make_shared<InfoOverlay>(*this, std::get<2>(result));
-                        }
-                        else {
-                            currentOverlay = std::make_shared<ErrorOverlay>(*this, std::get<1>(result), std::get<2>(result));
-                        }
+                        this->removeOverlay();
+                        startBackup(0);
                     },
                     [this]() { this->removeOverlay(); });
             }
@@ -393,14 +442,8 @@ void MainScreen::handleEvents(const InputState& input)
                 currentOverlay = std::make_shared<YesNoOverlay>(
                     *this, "Restore selected title?",
                     [this]() {
-                        size_t cellIndex = directoryList->index();
-                        auto result      = io::restore(hid.fullIndex(), cellIndex, nameFromCell(cellIndex));
-                        if (std::get<0>(result)) {
-                            currentOverlay = std::make_shared<InfoOverlay>(*this, std::get<2>(result));
-                        }
-                        else {
-                            currentOverlay = std::make_shared<ErrorOverlay>(*this, std::get<1>(result), std::get<2>(result));
-                        }
+                        this->removeOverlay();
+                        startRestore(directoryList->index());
                     },
                     [this]() { this->removeOverlay(); });
             }
@@ -492,15 +535,14 @@ void MainScreen::handleEvents(const InputState& input)
         if (MS::multipleSelectionEnabled()) {
             directoryList->resetIndex();
             std::vector<size_t> list = MS::selectedEntries();
-            for (size_t i = 0, sz = list.size(); i < sz; i++) {
-                auto result = io::backup(list.at(i), directoryList->index());
-                if (std::get<0>(result)) {
-                    currentOverlay = std::make_shared<InfoOverlay>(*this, std::get<2>(result));
-                }
-                else {
-                    currentOverlay = std::make_shared<ErrorOverlay>(*this, std::get<1>(result), std::get<2>(result));
+            Job::start([list]() {
+                // multiple selection doesn't ask for a folder name, the last outcome is the one shown
+                Job::Outcome result(true, 0, "");
+                for (size_t i = 0, sz = list.size(); i < sz; i++) {
+                    result = io::backup(list.at(i), 0, StringUtils::UTF8toUTF16(DateTime::dateTimeStr().c_str()));
                 }
-            }
+                return result;
+            });
             MS::clearSelectedEntries();
             updateButtons();
         }
@@ -508,13 +550,8 @@ void MainScreen::handleEvents(const InputState& input)
             currentOverlay = std::make_shared<YesNoOverlay>(
                 *this, "Backup selected save?",
                 [this]() {
-                    auto result = io::backup(hid.fullIndex(), directoryList->index());
-                    if (std::get<0>(result)) {
-                        currentOverlay = std::make_shared<InfoOverlay>(*this, std::get<2>(result));
-                    }
-                    else {
-                        currentOverlay = std::make_shared<ErrorOverlay>(*this, std::get<1>(result), std::get<2>(result));
-                    }
+                    this->removeOverlay();
+                    startBackup(directoryList->index());
                 },
                 [this]() { this->removeOverlay(); });
         }
@@ -530,13 +567,8 @@ void MainScreen::handleEvents(const InputState& input)
             currentOverlay = std::make_shared<YesNoOverlay>(
                 *this, "Restore selected save?",
                 [this, cellIndex]() {
-                    auto result = io::restore(hid.fullIndex(), cellIndex, nameFromCell(cellIndex));
-                    if (std::get<0>(result)) {
-                        currentOverlay = std::make_shared<InfoOverlay>(*this, std::get<2>(result));
-                    }
-                    else {
-                        currentOverlay = std::make_shared<ErrorOverlay>(*this, std::get<1>(result), std::get<2>(result));
-                    }
+                    this->removeOverlay();
+                    startRestore(cellIndex);
                 },
                 [this]() { this->removeOverlay(); });
         }
@@ -0,0 +1,117 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "benchmark.hpp"
+#include "archive.hpp"
+#include "fsstream.hpp"
+#include "io.hpp"
+#include "logging.hpp"
+#include "server.hpp"
+#include <3ds.h>
+#include <format>
+#include <memory>
+
+namespace {
+    constexpr u32 BENCHMARK_SIZE = 0x400000;
+    // even, so each mode goes first in half of the runs
+    constexpr int BENCHMARK_RUNS = 4;
+
+    // Writes BENCHMARK_SIZE bytes in BUFFER_SIZE chunks, the same way io::copyFile does, and
+    // returns the elapsed time in milliseconds, or a negative value on failure.
+    double writeFile(const std::u16string& path, const u8* buf, bool deferred)
+    {
+        FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, path.data()));
+
+        const u64 start = svcGetSystemTick();
+        FSStream stream(Archive::sdmc(), path, FS_OPEN_WRITE, BENCHMARK_SIZE);
+        if (!stream.good()) {
+            return -1;
+        }
+        if (deferred) {
+            stream.deferFlush();
+        }
+        for (u32 offset = 0; offset < BENCHMARK_SIZE; offset += BUFFER_SIZE) {
+            u32 chunk = BENCHMARK_SIZE - offset > BUFFER_SIZE ? BUFFER_SIZE : BENCHMARK_SIZE - offset;
+            if (stream.write(buf, chunk) != chunk) {
+                stream.close();
+                return -1;
+            }
+        }
+        Result res = stream.close();
+        if (R_FAILED(res)) {
+            return -1;
+        }
+        return (svcGetSystemTick() - start) / (double)CPU_TICKS_PER_MSEC;
+    }
+
+    Server::HttpResponse fsstream(const std::string&, const std::string&)
+    {
+        static const std::u16string path = StringUtils::UTF8toUTF16("/3ds/Checkpoint/benchmark.bin");
+
+        std::unique_ptr<u8[]> buf(new u8[BUFFER_SIZE]);
+        for (u32 i = 0; i < BUFFER_SIZE; i++) {
+            buf[i] = (u8)i;
+        }
+
+        double flushed = 0, deferred = 0;
+        for (int run = 0; run < BENCHMARK_RUNS; run++) {
+            // alternate the modes so neither one consistently benefits from a warm card
+            double a, b;
+            if (run & 1) {
+                b = writeFile(path, buf.get(), true);
+                a = writeFile(path, buf.get(), false);
+            }
+            else {
+                a = writeFile(path, buf.get(), false);
+                b = writeFile(path, buf.get(), true);
+            }
+            if (a < 0 || b < 0) {
+                FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, path.data()));
+                return {500, "text/plain", "Failed to write the benchmark file."};
+            }
+            flushed += a;
+            deferred += b;
+        }
+        FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, path.data()));
+
+        flushed /= BENCHMARK_RUNS;
+        deferred /= BENCHMARK_RUNS;
+        auto kibps = [](double ms) { return ms > 0 ? (BENCHMARK_SIZE / 1024.0) / (ms / 1000.0) : 0.0; };
+
+        std::string body = std::format("FSStream write, {} KiB in 0x{:X} byte chunks, average of {} runs\n", BENCHMARK_SIZE / 1024, BUFFER_SIZE,
+            BENCHMARK_RUNS);
+        body += std::format("flush per chunk: {:.1f} ms ({:.0f} KiB/s)\n", flushed, kibps(flushed));
+        body += std::format("deferred flush:  {:.1f} ms ({:.0f} KiB/s)\n", deferred, kibps(deferred));
+        body += std::format("speedup:         {:.2f}x\n", deferred > 0 ? flushed / deferred : 0.0);
+        Logging::info("FSStream benchmark: flush per chunk {:.1f} ms, deferred flush {:.1f} ms.", flushed, deferred);
+        return {200, "text/plain", body};
+    }
+}
+
+void Benchmark::init(void)
+{
+    Server::registerHandler("/benchmark/fsstream", fsstream);
+}
@@ -66,6 +66,15 @@ Configuration::Configuration(void)
                     (*mJson)["scan_cart"] = false;
                     updateJson            = true;
                 }
+                if (!(mJson->contains("incremental_backups") && (*mJson)["incremental_backups"].is_boolean())) {
+                    (*mJson)["incremental_backups"] = false;
+                    updateJson                      = true;
+                }
+                if (!(mJson->contains("backup_format") && (*mJson)["backup_format"].is_string() &&
+                        ((*mJson)["backup_format"] == "files" || (*mJson)["backup_format"] == "bundle"))) {
+                    (*mJson)["backup_format"] = "files";
+                    updateJson                = true;
+                }
                 if (!(mJson->contains("filter") && (*mJson)["filter"].is_array())) {
                     (*mJson)["filter"] = nlohmann::json::array();
                     updateJson         = true;
@@ -133,6 +142,9 @@ Configuration::Configuration(void)
             mNandSaves = (*mJson)["nand_saves"];
             mScanCard  = (*mJson)["scan_cart"];
 
+            mIncrementalBackups = (*mJson)["incremental_backups"];
+            mBundledBackups     = (*mJson)["backup_format"] == "bundle";
+
             // parse additional save folders
             auto js = (*mJson)["additional_save_folders"];
             for (auto it = js.begin(); it != js.end(); ++it) {
@@ -202,6 +214,16 @@ bool Configuration::nandSaves(void)
     return mNandSaves;
 }
 
+bool Configuration::incrementalBackups(void)
+{
+    return mIncrementalBackups;
+}
+
+bool Configuration::bundledBackups(void)
+{
+    return mBundledBackups;
+}
+
 std::vector<std::u16string> Configuration::additionalSaveFolders(u64 id)
 {
     std::vector<std::u16string> emptyvec;
@@ -25,6 +25,10 @@
  */
 
 #include "directory.hpp"
+#include <memory>
+
+// entries fetched per FSDIR_Read call, one IPC round trip each
+static constexpr u32 READ_BATCH = 32;
 
 Directory::Directory(FS_Archive archive, const std::u16string& root)
 {
@@ -37,18 +41,26 @@ Directory::Directory(FS_Archive archive, const std::u16string& root)
         return;
     }
 
+    std::unique_ptr<FS_DirectoryEntry[]> batch(new FS_DirectoryEntry[READ_BATCH]);
     u32 result;
     do {
-        FS_DirectoryEntry item;
-        mError = FSDIR_Read(handle, &result, 1, &item);
-        if (result == 1) {
-            mList.push_back(item);
+        result = 0;
+        mError = FSDIR_Read(handle, &result, READ_BATCH, batch.get());
+        for (u32 i = 0; i < result; i++) {
+            const char16_t* name = (const char16_t*)batch[i].name;
+            u16 length           = 0;
+            while (length < sizeof(batch[i].name) / sizeof(batch[i].name[0]) && name[length] != 0) {
+                length++;
+            }
+            mList.push_back({(u32)mNames.size(), length, batch[i].attributes, batch[i].fileSize});
+            mNames.append(name, length);
         }
-    } while (result);
+    } while (R_SUCCEEDED(mError) && result > 0);
 
     mError = FSDIR_Close(handle);
     if (R_FAILED(mError)) {
         mList.clear();
+        mNames.clear();
         return;
     }
 
@@ -67,12 +79,17 @@ bool Directory::good(void)
 
 std::u16string Directory::entry(size_t index)
 {
-    return index < mList.size() ? (char16_t*)mList.at(index).name : StringUtils::UTF8toUTF16("");
+    return index < mList.size() ? mNames.substr(mList[index].offset, mList[index].length) : StringUtils::UTF8toUTF16("");
+}
+
+u64 Directory::fileSize(size_t index)
+{
+    return index < mList.size() ? mList[index].fileSize : 0;
 }
 
 bool Directory::folder(size_t index)
 {
-    return index < mList.size() ? (mList.at(index).attributes & FS_ATTRIBUTE_DIRECTORY) != 0 : false;
+    return index < mList.size() ? (mList[index].attributes & FS_ATTRIBUTE_DIRECTORY) != 0 : false;
 }
 
 size_t Directory::size(void)
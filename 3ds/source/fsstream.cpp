@@ -28,9 +28,12 @@
 
 FSStream::FSStream(FS_Archive archive, const std::u16string& path, u32 flags)
 {
-    mGood   = false;
-    mSize   = 0;
-    mOffset = 0;
+    mGood          = false;
+    mSize          = 0;
+    mOffset        = 0;
+    mDeferFlush    = false;
+    mFlushInterval = 0;
+    mUnflushed     = 0;
 
     mResult = FSUSER_OpenFile(&mHandle, archive, fsMakePath(PATH_UTF16, path.data()), flags, 0);
     if (R_SUCCEEDED(mResult)) {
@@ -41,9 +44,12 @@ FSStream::FSStream(FS_Archive archive, const std::u16string& path, u32 flags)
 
 FSStream::FSStream(FS_Archive archive, const std::u16string& path, u32 flags, u32 size)
 {
-    mGood   = false;
-    mSize   = size;
-    mOffset = 0;
+    mGood          = false;
+    mSize          = size;
+    mOffset        = 0;
+    mDeferFlush    = false;
+    mFlushInterval = 0;
+    mUnflushed     = 0;
 
     mResult = FSUSER_OpenFile(&mHandle, archive, fsMakePath(PATH_UTF16, path.data()), flags, 0);
     if (R_FAILED(mResult)) {
@@ -62,7 +68,24 @@ FSStream::FSStream(FS_Archive archive, const std::u16string& path, u32 flags, u3
 
 Result FSStream::close(void)
 {
-    mResult = FSFILE_Close(mHandle);
+    Result flushed = mUnflushed > 0 ? flush() : 0;
+    mResult        = FSFILE_Close(mHandle);
+    if (R_FAILED(flushed)) {
+        mResult = flushed;
+    }
+    return mResult;
+}
+
+void FSStream::deferFlush(u32 interval)
+{
+    mDeferFlush    = true;
+    mFlushInterval = interval;
+}
+
+Result FSStream::flush(void)
+{
+    mResult    = FSFILE_Flush(mHandle);
+    mUnflushed = 0;
     return mResult;
 }
 
@@ -97,8 +120,14 @@ u32 FSStream::read(void* buf, u32 sz)
 u32 FSStream::write(const void* buf, u32 sz)
 {
     u32 wt  = 0;
-    mResult = FSFILE_Write(mHandle, &wt, mOffset, buf, sz, FS_WRITE_FLUSH);
+    mResult = FSFILE_Write(mHandle, &wt, mOffset, buf, sz, mDeferFlush ? 0 : FS_WRITE_FLUSH);
     mOffset += wt;
+    if (mDeferFlush) {
+        mUnflushed += wt;
+        if (mFlushInterval > 0 && mUnflushed >= mFlushInterval) {
+            flush();
+        }
+    }
     return wt;
 }
 
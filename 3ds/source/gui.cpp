@@ -60,7 +60,6 @@ void Gui::exit(void)
 void Gui::frameEnd(void)
 {
     C3D_FrameEnd(0);
-    g_timer += 0.025f;
 }
 
 void Gui::drawPulsingOutline(u32 x, u32 y, u16 w, u16 h, u8 size, u32 color)
@@ -0,0 +1,173 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "iconcache.hpp"
+#include "archive.hpp"
+#include "gui.hpp"
+#include "smdh.hpp"
+#include "title.hpp"
+#include <atomic>
+#include <list>
+#include <mutex>
+
+namespace {
+    // three pages of the title grid, so a recycled texture was never drawn in the frame before
+    constexpr size_t CAPACITY  = 96;
+    constexpr size_t ICON_SIZE = 0x900 * sizeof(u16);
+
+    const Tex3DS_SubTexture subt3x = {48, 48, 0.0f, 48 / 64.0f, 48 / 64.0f, 0.0f};
+
+    struct Slot {
+        u64 id;
+        // nullptr when the icon couldn't be read, those are retried once the source changes
+        C3D_Tex* tex;
+    };
+
+    // most recently drawn first
+    std::list<Slot> slots;
+    std::unordered_map<u64, std::list<Slot>::iterator> lookup;
+    u32 seenGeneration = 0;
+
+    std::mutex sourceMutex;
+    std::u16string sourcePath;
+    std::unordered_map<u64, u32> sourceOffsets;
+    std::atomic<u32> generation = 0;
+
+    void upload(C3D_Tex* tex, const u16* icon)
+    {
+        u16* dest = (u16*)tex->data + (64 - 48) * 64;
+        for (int j = 0; j < 48; j += 8) {
+            memcpy(dest, icon, 48 * 8 * sizeof(u16));
+            icon += 48 * 8;
+            dest += 64 * 8;
+        }
+        C3D_TexFlush(tex);
+    }
+
+    void release(C3D_Tex* tex)
+    {
+        if (tex) {
+            C3D_TexDelete(tex);
+            delete tex;
+        }
+    }
+}
+
+void IconCache::setSource(const std::u16string& path, std::unordered_map<u64, u32> offsets)
+{
+    std::lock_guard<std::mutex> lock(sourceMutex);
+    sourcePath    = path;
+    sourceOffsets = std::move(offsets);
+    generation++;
+}
+
+bool IconCache::read(u64 id, FS_MediaType media, u16* dst)
+{
+    {
+        std::lock_guard<std::mutex> lock(sourceMutex);
+        auto it = sourceOffsets.find(id);
+        Handle handle;
+        if (it != sourceOffsets.end() &&
+            R_SUCCEEDED(FSUSER_OpenFile(&handle, Archive::sdmc(), fsMakePath(PATH_UTF16, sourcePath.data()), FS_OPEN_READ, 0))) {
+            u32 read   = 0;
+            Result res = FSFILE_Read(handle, &read, it->second, dst, ICON_SIZE);
+            FSFILE_Close(handle);
+            if (R_SUCCEEDED(res) && read == ICON_SIZE) {
+                return true;
+            }
+        }
+    }
+
+    smdh_s* smdh = id == TID_PKSM ? loadSMDH("romfs:/PKSM.smdh") : loadSMDH((u32)id, (u32)(id >> 32), media);
+    if (smdh == NULL) {
+        return false;
+    }
+    memcpy(dst, smdh->bigIconData, ICON_SIZE);
+    delete smdh;
+    return true;
+}
+
+C2D_Image IconCache::get(u64 id, FS_MediaType media)
+{
+    if (seenGeneration != generation) {
+        seenGeneration = generation;
+        for (auto it = slots.begin(); it != slots.end();) {
+            if (it->tex == nullptr) {
+                lookup.erase(it->id);
+                it = slots.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    auto it = lookup.find(id);
+    if (it != lookup.end()) {
+        slots.splice(slots.begin(), slots, it->second);
+    }
+    else {
+        u16 icon[0x900];
+        const bool found = IconCache::read(id, media, icon);
+
+        C3D_Tex* tex = nullptr;
+        if (slots.size() >= CAPACITY) {
+            tex = slots.back().tex;
+            lookup.erase(slots.back().id);
+            slots.pop_back();
+        }
+
+        if (found && tex == nullptr) {
+            tex = new C3D_Tex;
+            if (!C3D_TexInit(tex, 64, 64, GPU_RGB565)) {
+                delete tex;
+                tex = nullptr;
+            }
+        }
+        else if (!found) {
+            release(tex);
+            tex = nullptr;
+        }
+
+        if (tex) {
+            upload(tex, icon);
+        }
+        slots.push_front({id, tex});
+        lookup[id] = slots.begin();
+    }
+
+    C3D_Tex* tex = slots.front().tex;
+    return tex ? C2D_Image{tex, &subt3x} : Gui::noIcon();
+}
+
+void IconCache::exit(void)
+{
+    for (auto& slot : slots) {
+        release(slot.tex);
+    }
+    slots.clear();
+    lookup.clear();
+}
@@ -25,7 +25,13 @@
  */
 
 #include "io.hpp"
+#include "bundle.hpp"
 #include "loader.hpp"
+#include "trace.hpp"
+#include "xxhash.hpp"
+#include <cstring>
+#include <ctime>
+#include <unordered_map>
 
 bool io::fileExists(const std::string& path)
 {
@@ -41,102 +47,680 @@ bool io::fileExists(FS_Archive archive, const std::u16string& path)
     return exist;
 }
 
-size_t io::countFiles(FS_Archive arch, const std::u16string& path)
+static Result walk(FS_Archive arch, const std::u16string& root, const std::u16string& relative, io::Manifest& manifest)
 {
-    size_t count = 0;
-    Directory items(arch, path);
+    Directory items(arch, root + relative);
     if (!items.good()) {
-        return 0;
+        return items.error();
     }
+
     for (size_t i = 0, sz = items.size(); i < sz; i++) {
+        std::u16string path = relative + items.entry(i);
         if (items.folder(i)) {
-            std::u16string subdir = path + items.entry(i) + StringUtils::UTF8toUTF16("/");
-            count += io::countFiles(arch, subdir);
+            manifest.entries.push_back({path, 0, true});
+            Result res = walk(arch, root, path + StringUtils::UTF8toUTF16("/"), manifest);
+            if (R_FAILED(res)) {
+                return res;
+            }
         }
         else {
-            count++;
+            manifest.entries.push_back({path, items.fileSize(i), false});
+            manifest.files++;
+            manifest.bytes += items.fileSize(i);
         }
     }
-    return count;
+
+    return 0;
 }
 
-void io::copyFile(FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath)
+Result io::buildManifest(FS_Archive arch, const std::u16string& root, io::Manifest& manifest)
 {
-    g_isTransferringFile = true;
+    manifest.entries.clear();
+    manifest.files = 0;
+    manifest.bytes = 0;
+    return walk(arch, root, StringUtils::UTF8toUTF16(""), manifest);
+}
 
+namespace {
+    // publishes the transfer state to the UI for as long as a backup or restore is running
+    struct TransferScope {
+        TransferScope(const std::string& mode)
+        {
+            {
+                std::lock_guard<std::mutex> lock(g_transferMutex);
+                g_transferMode = mode;
+                g_currentFile.clear();
+            }
+            g_copyCount          = 0;
+            g_copyTotal          = 0;
+            g_copyBytes          = 0;
+            g_copyBytesTotal     = 0;
+            g_isTransferringFile = true;
+        }
+        ~TransferScope() { g_isTransferringFile = false; }
+    };
+
+    void beginCopy(const io::Manifest& manifest)
+    {
+        g_copyTotal      = manifest.files;
+        g_copyBytesTotal = manifest.bytes;
+        g_copyStartTime  = osGetTime();
+    }
+}
+
+Result io::copyFile(FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath, u64* hash)
+{
+    Trace::Span span("copyFile");
     u32 size = 0;
     FSStream input(srcArch, srcPath, FS_OPEN_READ);
     if (input.good()) {
         size = input.size() > BUFFER_SIZE ? BUFFER_SIZE : input.size();
     }
     else {
-        Logging::error("Failed to open source file {} during copy with result {}. Skipping...", StringUtils::UTF16toUTF8(srcPath), input.result());
-        return;
+        Logging::error("Failed to open source file {} during copy with result {}.", StringUtils::UTF16toUTF8(srcPath), input.result());
+        return input.result();
     }
 
+    Result res = 0;
     FSStream output(dstArch, dstPath, FS_OPEN_WRITE, input.size());
     if (output.good()) {
         size_t slashpos = srcPath.rfind(StringUtils::UTF8toUTF16("/"));
-        g_currentFile   = srcPath.substr(slashpos + 1, srcPath.length() - slashpos - 1);
+        {
+            std::lock_guard<std::mutex> lock(g_transferMutex);
+            g_currentFile = srcPath.substr(slashpos + 1, srcPath.length() - slashpos - 1);
+        }
+
+        output.deferFlush();
 
+        XXH64 state;
         u32 rd;
         u8* buf = new u8[size];
         do {
             rd = input.read(buf, size);
-            output.write(buf, rd);
-
-            // avoid freezing the UI
-            C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
-            g_screen->drawTop();
-            C2D_SceneBegin(g_bottom);
-            g_screen->drawBottom();
-            Gui::frameEnd();
+            if (R_FAILED(input.result())) {
+                res = input.result();
+                break;
+            }
+            if (output.write(buf, rd) != rd) {
+                res = R_FAILED(output.result()) ? output.result() : -1;
+                break;
+            }
+            if (hash != nullptr) {
+                state.update(buf, rd);
+            }
+            g_copyBytes += rd;
         } while (!input.eof());
         delete[] buf;
         g_copyCount++;
+
+        if (hash != nullptr) {
+            *hash = state.digest();
+        }
     }
     else {
-        Logging::error(
-            "Failed to open destination file {} during copy with result {}. Skipping...", StringUtils::UTF16toUTF8(dstPath), output.result());
+        Logging::error("Failed to open destination file {} during copy with result {}.", StringUtils::UTF16toUTF8(dstPath), output.result());
+        res = output.result();
     }
 
     input.close();
-    output.close();
-
-    g_isTransferringFile = false;
+    Result closed = output.close();
+    return R_FAILED(res) ? res : closed;
 }
 
 Result io::copyDirectory(FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath)
 {
-    Result res = 0;
-    bool quit  = false;
-    Directory items(srcArch, srcPath);
+    io::Manifest manifest;
+    Result res = io::buildManifest(srcArch, srcPath, manifest);
+    return R_SUCCEEDED(res) ? io::copyManifest(manifest, srcArch, dstArch, srcPath, dstPath) : res;
+}
 
-    if (!items.good()) {
-        return items.error();
+Result io::copyManifest(
+    const io::Manifest& manifest, FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath)
+{
+    for (const auto& entry : manifest.entries) {
+        if (entry.directory) {
+            Result res = io::createDirectory(dstArch, dstPath + entry.path);
+            if (R_FAILED(res) && (u32)res != 0xC82044B9) {
+                return res;
+            }
+        }
+        else {
+            // a file left out would be missing from the snapshot, so the first failure stops the copy
+            Result res = io::copyFile(srcArch, dstArch, (entry.origin.empty() ? srcPath : entry.origin) + entry.path, dstPath + entry.path);
+            if (R_FAILED(res)) {
+                return res;
+            }
+        }
     }
 
-    for (size_t i = 0, sz = items.size(); i < sz && !quit; i++) {
-        std::u16string newsrc = srcPath + items.entry(i);
-        std::u16string newdst = dstPath + items.entry(i);
+    return 0;
+}
 
-        if (items.folder(i)) {
-            res = io::createDirectory(dstArch, newdst);
-            if (R_SUCCEEDED(res) || (u32)res == 0xC82044B9) {
-                newsrc += StringUtils::UTF8toUTF16("/");
-                newdst += StringUtils::UTF8toUTF16("/");
-                res = io::copyDirectory(srcArch, dstArch, newsrc, newdst);
+namespace {
+    // Every incremental backup carries an index listing the full tree it restores to, with the size and
+    // XXH64 of each file. Files that were unchanged when the backup was taken are not stored again: their
+    // entry names the sibling backup folder that physically holds them instead. References always point
+    // at the folder with the data, never at another reference, so resolving one never chains.
+    constexpr int INDEX_VERSION = 1;
+
+    struct IndexEntry {
+        u64 size;
+        u64 hash;
+        std::u16string origin; // sibling folder holding the data, empty when stored in this backup
+    };
+
+    struct BackupIndex {
+        u64 created = 0;
+        std::vector<std::u16string> directories;
+        std::map<std::u16string, IndexEntry> files;
+    };
+
+    std::u16string indexPath(const std::u16string& folder)
+    {
+        return folder + StringUtils::UTF8toUTF16("/.checkpoint");
+    }
+
+    // splits "/path/to/backup" into "/path/to" and "backup"
+    std::pair<std::u16string, std::u16string> splitFolder(const std::u16string& folder)
+    {
+        size_t slashpos = folder.rfind(StringUtils::UTF8toUTF16("/"));
+        return {folder.substr(0, slashpos), folder.substr(slashpos + 1)};
+    }
+
+    bool readIndex(const std::u16string& folder, BackupIndex& index)
+    {
+        FSStream stream(Archive::sdmc(), indexPath(folder), FS_OPEN_READ);
+        if (!stream.good()) {
+            return false;
+        }
+
+        std::string data(stream.size(), '\0');
+        stream.read(data.data(), data.size());
+        stream.close();
+
+        // every field is type checked, nlohmann::json throws on a mismatch and a damaged index only means a full copy
+        auto unreadable = [&folder]() {
+            Logging::warning("Ignoring unreadable backup index in {}.", StringUtils::UTF16toUTF8(folder));
+            return false;
+        };
+        nlohmann::json json = nlohmann::json::parse(data, nullptr, false);
+        if (!json.is_object() || !json["version"].is_number_unsigned() || json["version"] != INDEX_VERSION || !json["directories"].is_array() ||
+            !json["files"].is_object() || (json.contains("created") && !json["created"].is_number_unsigned())) {
+            return unreadable();
+        }
+
+        BackupIndex parsed;
+        parsed.created = json.value("created", 0ULL);
+        for (const auto& dir : json["directories"]) {
+            if (!dir.is_string()) {
+                return unreadable();
             }
-            else {
-                quit = true;
+            parsed.directories.push_back(StringUtils::UTF8toUTF16(dir.get<std::string>().c_str()));
+        }
+        for (auto it = json["files"].begin(); it != json["files"].end(); ++it) {
+            const auto& file = it.value();
+            if (!file.is_object() || !file.contains("size") || !file["size"].is_number_unsigned() || !file.contains("hash") ||
+                !file["hash"].is_string() || (file.contains("origin") && !file["origin"].is_string())) {
+                return unreadable();
+            }
+            IndexEntry entry;
+            entry.size   = file["size"];
+            entry.hash   = strtoull(file["hash"].get<std::string>().c_str(), NULL, 16);
+            entry.origin = StringUtils::UTF8toUTF16(file.value("origin", "").c_str());
+            parsed.files.emplace(StringUtils::UTF8toUTF16(it.key().c_str()), entry);
+        }
+
+        index = std::move(parsed);
+        return true;
+    }
+
+    Result writeIndex(const std::u16string& folder, const BackupIndex& index)
+    {
+        nlohmann::json json;
+        json["version"]     = INDEX_VERSION;
+        json["created"]     = index.created;
+        json["directories"] = nlohmann::json::array();
+        json["files"]       = nlohmann::json::object();
+        for (const auto& dir : index.directories) {
+            json["directories"].push_back(StringUtils::UTF16toUTF8(dir));
+        }
+        for (const auto& [path, entry] : index.files) {
+            nlohmann::json& file = json["files"][StringUtils::UTF16toUTF8(path)];
+            file["size"]         = entry.size;
+            file["hash"]         = StringUtils::format("%016llX", entry.hash);
+            if (!entry.origin.empty()) {
+                file["origin"] = StringUtils::UTF16toUTF8(entry.origin);
             }
         }
+
+        // the index may shrink when rewritten, so don't leave a longer old one behind
+        std::string data    = json.dump();
+        std::u16string path = indexPath(folder);
+        FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, path.data()));
+        FSStream stream(Archive::sdmc(), path, FS_OPEN_WRITE, data.size());
+        if (!stream.good()) {
+            return stream.result();
+        }
+        stream.write(data.data(), data.size());
+        return stream.close();
+    }
+
+    Result hashFile(FS_Archive arch, const std::u16string& path, u64& hash)
+    {
+        FSStream input(arch, path, FS_OPEN_READ);
+        if (!input.good()) {
+            return input.result();
+        }
+
+        XXH64 state;
+        u32 size = input.size() > BUFFER_SIZE ? BUFFER_SIZE : input.size();
+        u8* buf  = new u8[size];
+        while (!input.eof()) {
+            u32 rd = input.read(buf, size);
+            if (R_FAILED(input.result())) {
+                break;
+            }
+            state.update(buf, rd);
+        }
+        delete[] buf;
+
+        Result res = input.result();
+        input.close();
+        hash = state.digest();
+        return res;
+    }
+
+    // Picks the most recent indexed backup among the siblings of exclude, which is what a new backup
+    // gets compared against. Backups taken without an index can't serve as a base.
+    bool newestIndex(const std::u16string& parent, const std::u16string& exclude, std::u16string& name, BackupIndex& index)
+    {
+        Directory siblings(Archive::sdmc(), parent);
+        if (!siblings.good()) {
+            return false;
+        }
+
+        bool found = false;
+        for (size_t i = 0, sz = siblings.size(); i < sz; i++) {
+            BackupIndex candidate;
+            std::u16string folder = parent + StringUtils::UTF8toUTF16("/") + siblings.entry(i);
+            if (!siblings.folder(i) || siblings.entry(i) == exclude || !readIndex(folder, candidate)) {
+                continue;
+            }
+            if (!found || candidate.created > index.created) {
+                name  = siblings.entry(i);
+                index = std::move(candidate);
+                found = true;
+            }
+        }
+
+        return found;
+    }
+
+    // Copies the manifest into folder, writing only the files whose size or hash differ from the newest
+    // indexed sibling backup. Everything else is recorded in the new index by reference.
+    Result copyIncremental(const io::Manifest& manifest, FS_Archive archive, const std::u16string& folder)
+    {
+        auto [parent, name] = splitFolder(folder);
+        std::u16string baseName;
+        BackupIndex base, index;
+        if (newestIndex(parent, name, baseName, base)) {
+            Logging::info("Comparing against backup {}.", StringUtils::UTF16toUTF8(baseName));
+        }
+        index.created = std::max<u64>(time(NULL), base.created + 1);
+
+        std::u16string srcPath = StringUtils::UTF8toUTF16("/");
+        std::u16string dstPath = folder + StringUtils::UTF8toUTF16("/");
+        size_t reused          = 0;
+        for (const auto& entry : manifest.entries) {
+            if (entry.directory) {
+                Result res = io::createDirectory(Archive::sdmc(), dstPath + entry.path);
+                if (R_FAILED(res) && (u32)res != 0xC82044B9) {
+                    return res;
+                }
+                index.directories.push_back(entry.path);
+                continue;
+            }
+
+            auto previous = base.files.find(entry.path);
+            u64 hash      = 0;
+            if (previous != base.files.end() && previous->second.size == entry.size && R_SUCCEEDED(hashFile(archive, srcPath + entry.path, hash)) &&
+                hash == previous->second.hash) {
+                const std::u16string& origin = previous->second.origin.empty() ? baseName : previous->second.origin;
+                index.files[entry.path]      = {entry.size, hash, origin};
+                g_copyBytes += entry.size;
+                g_copyCount++;
+                reused++;
+                continue;
+            }
+
+            // an index missing a file would delete it from the save on restore, so the caller drops the whole backup instead
+            Result res = io::copyFile(archive, Archive::sdmc(), srcPath + entry.path, dstPath + entry.path, &hash);
+            if (R_FAILED(res)) {
+                return res;
+            }
+            index.files[entry.path] = {entry.size, hash, {}};
+        }
+
+        Logging::info("Incremental backup stored {} of {} files, {} reused.", manifest.files - reused, manifest.files, reused);
+        return writeIndex(folder, index);
+    }
+
+    // A backup with an index restores from it, so files kept by reference in an older backup are read
+    // from there. Plain backups restore whatever is in the folder.
+    Result backupManifest(const std::u16string& srcPath, io::Manifest& manifest)
+    {
+        std::u16string folder = srcPath.substr(0, srcPath.length() - 1);
+        BackupIndex index;
+        if (!readIndex(folder, index)) {
+            return io::buildManifest(Archive::sdmc(), srcPath, manifest);
+        }
+
+        std::u16string parent = splitFolder(folder).first + StringUtils::UTF8toUTF16("/");
+        manifest.entries.clear();
+        manifest.files = index.files.size();
+        manifest.bytes = 0;
+        for (const auto& dir : index.directories) {
+            manifest.entries.push_back({dir, 0, true});
+        }
+        for (const auto& [path, entry] : index.files) {
+            std::u16string origin = entry.origin.empty() ? std::u16string() : parent + entry.origin + StringUtils::UTF8toUTF16("/");
+            manifest.entries.push_back({path, entry.size, false, origin});
+            manifest.bytes += entry.size;
+        }
+
+        return 0;
+    }
+
+    // Before a backup folder is deleted or overwritten, hands the files other backups reference in it
+    // over to them: the first dependent receives a physical copy, any later one is pointed at that copy.
+    Result releaseBackup(const std::u16string& folder)
+    {
+        auto [parent, name] = splitFolder(folder);
+        Directory siblings(Archive::sdmc(), parent);
+        if (!siblings.good()) {
+            return siblings.error();
+        }
+
+        std::map<std::u16string, std::u16string> moved;
+        for (size_t i = 0, sz = siblings.size(); i < sz; i++) {
+            std::u16string dependent = parent + StringUtils::UTF8toUTF16("/") + siblings.entry(i);
+            BackupIndex index;
+            if (!siblings.folder(i) || siblings.entry(i) == name || !readIndex(dependent, index)) {
+                continue;
+            }
+
+            bool changed = false;
+            for (auto& [path, entry] : index.files) {
+                if (entry.origin != name) {
+                    continue;
+                }
+
+                auto holder = moved.find(path);
+                if (holder != moved.end()) {
+                    entry.origin = holder->second;
+                }
+                else {
+                    if (!changed) {
+                        for (const auto& dir : index.directories) {
+                            io::createDirectory(Archive::sdmc(), dependent + StringUtils::UTF8toUTF16("/") + dir);
+                        }
+                    }
+                    Result res = io::copyFile(Archive::sdmc(), Archive::sdmc(), folder + StringUtils::UTF8toUTF16("/") + path,
+                        dependent + StringUtils::UTF8toUTF16("/") + path);
+                    if (R_FAILED(res)) {
+                        return res;
+                    }
+                    entry.origin = {};
+                    moved.emplace(path, siblings.entry(i));
+                }
+                changed = true;
+            }
+
+            if (changed) {
+                Result res = writeIndex(dependent, index);
+                if (R_FAILED(res)) {
+                    return res;
+                }
+            }
+        }
+
+        return 0;
+    }
+}
+
+namespace {
+    bool isBundle(const std::u16string& path)
+    {
+        return Bundle::hasExtension(StringUtils::UTF16toUTF8(path)) && io::fileExists(Archive::sdmc(), path);
+    }
+
+    // empties an archive before a restore; extdata can't be deleted from its root in one go
+    void wipeArchive(FS_Archive archive, Mode_t mode)
+    {
+        std::u16string root = StringUtils::UTF8toUTF16("/");
+        if (mode != MODE_EXTDATA) {
+            FSUSER_DeleteDirectoryRecursively(archive, fsMakePath(PATH_UTF16, root.data()));
+        }
         else {
-            io::copyFile(srcArch, dstArch, newsrc, newdst);
+            io::deleteFolderRecursively(archive, root);
+        }
+    }
+
+    // Streams the archive into a single bundle file. Unlike a folder copy a file can't just be skipped,
+    // since the index written up front already promised its body.
+    Result writeBundle(const io::Manifest& manifest, FS_Archive archive, const std::u16string& dstPath)
+    {
+        FSStream out(Archive::sdmc(), dstPath, FS_OPEN_WRITE, 0);
+        if (!out.good()) {
+            Logging::error("Failed to create bundle {} with result 0x{:08X}.", StringUtils::UTF16toUTF8(dstPath), out.result());
+            return out.result();
+        }
+        out.deferFlush();
+
+        Bundle::Writer writer([&out](const void* data, size_t size) { return out.write(data, size) == size; });
+        std::vector<Bundle::Entry> entries;
+        for (const auto& entry : manifest.entries) {
+            entries.push_back({StringUtils::UTF16toUTF8(entry.path), entry.size, entry.directory});
+        }
+
+        Result res = writer.writeIndex(entries) ? 0 : out.result();
+        for (auto it = manifest.entries.begin(); R_SUCCEEDED(res) && it != manifest.entries.end(); ++it) {
+            if (it->directory) {
+                continue;
+            }
+
+            FSStream input(archive, StringUtils::UTF8toUTF16("/") + it->path, FS_OPEN_READ);
+            if (!input.good()) {
+                Logging::error(
+                    "Failed to open source file {} during backup with result 0x{:08X}.", StringUtils::UTF16toUTF8(it->path), input.result());
+                res = input.result();
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> lock(g_transferMutex);
+                g_currentFile = it->path.substr(it->path.rfind(StringUtils::UTF8toUTF16("/")) + 1);
+            }
+
+            bool ok = writer.writeFile([&input](void* data, size_t size) { return (size_t)input.read(data, size); }, it->size,
+                [](size_t block) { g_copyBytes += block; });
+            input.close();
+            if (!ok) {
+                res = R_FAILED(out.result()) ? out.result() : -1;
+                break;
+            }
+            g_copyCount++;
+        }
+
+        if (!writer.finish() && R_SUCCEEDED(res)) {
+            res = R_FAILED(out.result()) ? out.result() : -1;
+        }
+        Result closed = out.close();
+        return R_FAILED(res) ? res : closed;
+    }
+
+    // Restores a bundle into the archive. The index is read before the archive is wiped, so a bundle
+    // that can't be opened leaves the current data in place.
+    Result restoreBundle(const std::u16string& srcPath, FS_Archive archive, Mode_t mode)
+    {
+        FSStream in(Archive::sdmc(), srcPath, FS_OPEN_READ);
+        if (!in.good()) {
+            Logging::error("Failed to open bundle {} with result 0x{:08X}.", StringUtils::UTF16toUTF8(srcPath), in.result());
+            return in.result();
+        }
+
+        Bundle::Reader reader([&in](void* data, size_t size) { return (size_t)in.read(data, size); });
+        std::vector<Bundle::Entry> entries;
+        if (!reader.readIndex(entries)) {
+            in.close();
+            Logging::error("Bundle {} has an unreadable index.", StringUtils::UTF16toUTF8(srcPath));
+            return -1;
+        }
+
+        io::Manifest manifest;
+        for (const auto& entry : entries) {
+            manifest.entries.push_back({StringUtils::UTF8toUTF16(entry.path.c_str()), entry.size, entry.directory});
+            manifest.files += entry.directory ? 0 : 1;
+            manifest.bytes += entry.size;
+        }
+
+        wipeArchive(archive, mode);
+        beginCopy(manifest);
+
+        Result res = 0;
+        for (auto it = manifest.entries.begin(); R_SUCCEEDED(res) && it != manifest.entries.end(); ++it) {
+            std::u16string path = StringUtils::UTF8toUTF16("/") + it->path;
+            if (it->directory) {
+                res = io::createDirectory(archive, path);
+                if ((u32)res == 0xC82044B9) {
+                    res = 0;
+                }
+                continue;
+            }
+
+            FSStream output(archive, path, FS_OPEN_WRITE, it->size);
+            if (!output.good()) {
+                Logging::error("Failed to open destination file {} during restore with result 0x{:08X}.", StringUtils::UTF16toUTF8(path),
+                    output.result());
+                res = output.result();
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> lock(g_transferMutex);
+                g_currentFile = it->path.substr(it->path.rfind(StringUtils::UTF8toUTF16("/")) + 1);
+            }
+
+            output.deferFlush();
+            bool ok = reader.readFile([&output](const void* data, size_t size) { return output.write(data, size) == size; }, it->size,
+                [](size_t block) { g_copyBytes += block; });
+            res = output.close();
+            if (!ok) {
+                Logging::error("Failed to restore {} from bundle {}.", StringUtils::UTF16toUTF8(it->path), StringUtils::UTF16toUTF8(srcPath));
+                res = -1;
+            }
+            g_copyCount++;
+        }
+
+        in.close();
+        return res;
+    }
+}
+
+static bool sameContents(FS_Archive firstArch, const std::u16string& first, FS_Archive secondArch, const std::u16string& second)
+{
+    FSStream a(firstArch, first, FS_OPEN_READ);
+    FSStream b(secondArch, second, FS_OPEN_READ);
+    bool same = a.good() && b.good() && a.size() == b.size();
+    if (same && a.size() > 0) {
+        u32 size = a.size() > BUFFER_SIZE ? BUFFER_SIZE : a.size();
+        u8* bufA = new u8[size];
+        u8* bufB = new u8[size];
+        while (same && !a.eof()) {
+            u32 rdA = a.read(bufA, size);
+            u32 rdB = b.read(bufB, size);
+            same    = R_SUCCEEDED(a.result()) && R_SUCCEEDED(b.result()) && rdA == rdB && rdA > 0 && memcmp(bufA, bufB, rdA) == 0;
+        }
+        delete[] bufA;
+        delete[] bufB;
+    }
+    if (a.good()) {
+        a.close();
+    }
+    if (b.good()) {
+        b.close();
+    }
+    return same;
+}
+
+Result io::syncManifest(
+    const io::Manifest& manifest, FS_Archive srcArch, FS_Archive dstArch, const std::u16string& srcPath, const std::u16string& dstPath)
+{
+    io::Manifest live;
+    Result res = io::buildManifest(dstArch, dstPath, live);
+    if (R_FAILED(res)) {
+        return res;
+    }
+
+    std::unordered_map<std::u16string, const io::ManifestEntry*> wanted, existing;
+    for (const auto& entry : manifest.entries) {
+        wanted.emplace(entry.path, &entry);
+    }
+    for (const auto& entry : live.entries) {
+        existing.emplace(entry.path, &entry);
+    }
+
+    // children come after their parents in a manifest, so walking it backwards empties folders before removing them
+    size_t deleted = 0;
+    for (auto it = live.entries.rbegin(); it != live.entries.rend(); ++it) {
+        auto match = wanted.find(it->path);
+        if (match == wanted.end() || match->second->directory != it->directory) {
+            std::u16string path = dstPath + it->path;
+            if (it->directory) {
+                FSUSER_DeleteDirectoryRecursively(dstArch, fsMakePath(PATH_UTF16, path.data()));
+            }
+            else {
+                FSUSER_DeleteFile(dstArch, fsMakePath(PATH_UTF16, path.data()));
+            }
+            existing.erase(it->path);
+            deleted++;
+        }
+    }
+
+    size_t written = 0;
+    for (const auto& entry : manifest.entries) {
+        auto current = existing.find(entry.path);
+        if (entry.directory) {
+            if (current == existing.end()) {
+                res = io::createDirectory(dstArch, dstPath + entry.path);
+                if (R_FAILED(res) && (u32)res != 0xC82044B9) {
+                    return res;
+                }
+            }
+            continue;
+        }
+
+        std::u16string src = (entry.origin.empty() ? srcPath : entry.origin) + entry.path;
+        std::u16string dst = dstPath + entry.path;
+        if (current != existing.end()) {
+            if (current->second->size == entry.size && sameContents(srcArch, src, dstArch, dst)) {
+                g_copyBytes += entry.size;
+                g_copyCount++;
+                continue;
+            }
+            // files keep the size they were created with, so a resized one has to be created anew
+            if (current->second->size != entry.size) {
+                FSUSER_DeleteFile(dstArch, fsMakePath(PATH_UTF16, dst.data()));
+            }
+        }
+        // a resized file was already deleted above, stop before more of the save is lost
+        res = io::copyFile(srcArch, dstArch, src, dst);
+        if (R_FAILED(res)) {
+            return res;
         }
+        written++;
     }
 
-    return res;
+    Logging::info("Synced {}: {} of {} files written, {} entries deleted.", StringUtils::UTF16toUTF8(dstPath), written, manifest.files, deleted);
+    return 0;
 }
 
 Result io::createDirectory(FS_Archive archive, const std::u16string& path)
@@ -183,14 +767,26 @@ Result io::deleteFolderRecursively(FS_Archive arch, const std::u16string& path)
     return 0;
 }
 
-std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
+std::u16string io::backupName(size_t cellIndex)
 {
+    if (cellIndex != 0) {
+        // we're overriding an existing folder
+        return StringUtils::UTF8toUTF16("");
+    }
+    return KeyboardManager::get().keyboard(DateTime::dateTimeStr());
+}
+
+std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex, const std::u16string& customPath)
+{
+    Trace::Span span("backup");
+
     const Mode_t mode      = Archive::mode();
     const bool isNewFolder = cellIndex == 0;
     Result res             = 0;
 
     Title title;
     TitleLoader::getTitle(title, index);
+    TransferScope scope("Backup");
 
     Logging::info("Started backup of {}. Title id: 0x{:08X}.", title.shortDescription().c_str(), title.lowId());
 
@@ -204,28 +800,28 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
         }
 
         if (R_SUCCEEDED(res)) {
-            std::string suggestion = DateTime::dateTimeStr();
-
-            std::u16string customPath;
-            if (MS::multipleSelectionEnabled()) {
-                customPath = isNewFolder ? StringUtils::UTF8toUTF16(suggestion.c_str()) : StringUtils::UTF8toUTF16("");
-            }
-            else {
-                customPath = isNewFolder ? KeyboardManager::get().keyboard(suggestion) : StringUtils::UTF8toUTF16("");
-            }
-
             std::u16string dstPath;
             if (!isNewFolder) {
-                // we're overriding an existing folder
+                // we're overriding an existing backup, which may have been written in another format
                 dstPath = mode == MODE_SAVE ? title.fullSavePath(cellIndex) : title.fullExtdataPath(cellIndex);
+                if (isBundle(dstPath)) {
+                    dstPath.erase(dstPath.length() - strlen(Bundle::EXTENSION));
+                }
             }
             else {
                 dstPath = mode == MODE_SAVE ? title.savePath() : title.extdataPath();
                 dstPath += StringUtils::UTF8toUTF16("/") + customPath;
             }
 
-            if (!isNewFolder || io::directoryExists(Archive::sdmc(), dstPath)) {
-                res = FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, dstPath.data()));
+            const bool bundled              = Configuration::getInstance().bundledBackups();
+            const std::u16string bundlePath = dstPath + StringUtils::UTF8toUTF16(Bundle::EXTENSION);
+            FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, bundlePath.data()));
+
+            if (io::directoryExists(Archive::sdmc(), dstPath)) {
+                res = releaseBackup(dstPath);
+                if (R_SUCCEEDED(res)) {
+                    res = FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, dstPath.data()));
+                }
                 if (R_FAILED(res)) {
                     FSUSER_CloseArchive(archive);
                     Logging::error("Failed to delete the existing backup directory recursively with result 0x{:08X}.", res);
@@ -233,7 +829,7 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
                 }
             }
 
-            res = io::createDirectory(Archive::sdmc(), dstPath);
+            res = bundled ? 0 : io::createDirectory(Archive::sdmc(), dstPath);
             if (R_FAILED(res)) {
                 FSUSER_CloseArchive(archive);
                 Logging::error("Failed to create destination directory.");
@@ -242,15 +838,29 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
 
             std::u16string copyPath = dstPath + StringUtils::UTF8toUTF16("/");
 
-            g_copyCount    = 0;
-            g_copyTotal    = io::countFiles(archive, StringUtils::UTF8toUTF16("/"));
-            g_transferMode = "Backup";
-
-            res = io::copyDirectory(archive, Archive::sdmc(), StringUtils::UTF8toUTF16("/"), copyPath);
+            io::Manifest manifest;
+            res = io::buildManifest(archive, StringUtils::UTF8toUTF16("/"), manifest);
+            if (R_SUCCEEDED(res)) {
+                beginCopy(manifest);
+                if (bundled) {
+                    res = writeBundle(manifest, archive, bundlePath);
+                }
+                else if (Configuration::getInstance().incrementalBackups()) {
+                    res = copyIncremental(manifest, archive, dstPath);
+                }
+                else {
+                    res = io::copyManifest(manifest, archive, Archive::sdmc(), StringUtils::UTF8toUTF16("/"), copyPath);
+                }
+            }
             if (R_FAILED(res)) {
                 std::string message = mode == MODE_SAVE ? "Failed to backup save." : "Failed to backup extdata.";
                 FSUSER_CloseArchive(archive);
-                FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, dstPath.data()));
+                if (bundled) {
+                    FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, bundlePath.data()));
+                }
+                else {
+                    FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, dstPath.data()));
+                }
                 Logging::error("{} Result {}.", message, res);
                 return std::make_tuple(false, res, message);
             }
@@ -269,16 +879,6 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
         u32 saveSize      = SPIGetCapacity(cardType);
         u32 sectorSize    = (saveSize < 0x10000) ? saveSize : 0x10000;
 
-        std::string suggestion = DateTime::dateTimeStr();
-
-        std::u16string customPath;
-        if (MS::multipleSelectionEnabled()) {
-            customPath = isNewFolder ? StringUtils::UTF8toUTF16(suggestion.c_str()) : StringUtils::UTF8toUTF16("");
-        }
-        else {
-            customPath = isNewFolder ? KeyboardManager::get().keyboard(suggestion) : StringUtils::UTF8toUTF16("");
-        }
-
         std::u16string dstPath;
         if (!isNewFolder) {
             // we're overriding an existing folder
@@ -319,6 +919,7 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
 
         FSStream stream(Archive::sdmc(), copyPath, FS_OPEN_WRITE, saveSize);
         if (stream.good()) {
+            stream.deferFlush();
             stream.write(saveFile, saveSize);
         }
         else {
@@ -340,11 +941,14 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, size_t cellIndex)
 
 std::tuple<bool, Result, std::string> io::restore(size_t index, size_t cellIndex, const std::string& nameFromCell)
 {
+    Trace::Span span("restore");
+
     const Mode_t mode = Archive::mode();
     Result res        = 0;
 
     Title title;
     TitleLoader::getTitle(title, index);
+    TransferScope scope("Restore");
 
     Logging::info("Started restore of {}. Title id: 0x{:08X}.", title.shortDescription().c_str(), title.lowId());
 
@@ -358,22 +962,21 @@ std::tuple<bool, Result, std::string> io::restore(size_t index, size_t cellIndex
         }
 
         if (R_SUCCEEDED(res)) {
-            std::u16string srcPath = mode == MODE_SAVE ? title.fullSavePath(cellIndex) : title.fullExtdataPath(cellIndex);
-            srcPath += StringUtils::UTF8toUTF16("/");
-            std::u16string dstPath = StringUtils::UTF8toUTF16("/");
+            std::u16string backupPath = mode == MODE_SAVE ? title.fullSavePath(cellIndex) : title.fullExtdataPath(cellIndex);
+            std::u16string srcPath    = backupPath + StringUtils::UTF8toUTF16("/");
+            std::u16string dstPath    = StringUtils::UTF8toUTF16("/");
 
-            if (mode != MODE_EXTDATA) {
-                FSUSER_DeleteDirectoryRecursively(archive, fsMakePath(PATH_UTF16, dstPath.data()));
+            if (isBundle(backupPath)) {
+                res = restoreBundle(backupPath, archive, mode);
             }
             else {
-                deleteFolderRecursively(archive, dstPath);
+                io::Manifest manifest;
+                res = backupManifest(srcPath, manifest);
+                if (R_SUCCEEDED(res)) {
+                    beginCopy(manifest);
+                    res = io::syncManifest(manifest, Archive::sdmc(), archive, srcPath, dstPath);
+                }
             }
-
-            g_copyCount    = 0;
-            g_copyTotal    = io::countFiles(Archive::sdmc(), srcPath);
-            g_transferMode = "Restore";
-
-            res = io::copyDirectory(Archive::sdmc(), archive, srcPath, dstPath);
             if (R_FAILED(res)) {
                 std::string message = mode == MODE_SAVE ? "Failed to restore save." : "Failed to restore extdata.";
                 FSUSER_CloseArchive(archive);
@@ -382,7 +985,10 @@ std::tuple<bool, Result, std::string> io::restore(size_t index, size_t cellIndex
             }
 
             if (mode == MODE_SAVE) {
-                res = FSUSER_ControlArchive(archive, ARCHIVE_ACTION_COMMIT_SAVE_DATA, NULL, 0, NULL, 0);
+                {
+                    Trace::Span commit("commit");
+                    res = FSUSER_ControlArchive(archive, ARCHIVE_ACTION_COMMIT_SAVE_DATA, NULL, 0, NULL, 0);
+                }
                 if (R_FAILED(res)) {
                     FSUSER_CloseArchive(archive);
                     Logging::error("Failed to commit save data with result 0x{:08X}.", res);
@@ -447,7 +1053,21 @@ std::tuple<bool, Result, std::string> io::restore(size_t index, size_t cellIndex
 
 void io::deleteBackupFolder(const std::u16string& path)
 {
-    Result res = FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, path.data()));
+    if (isBundle(path)) {
+        Result res = FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, path.data()));
+        if (R_FAILED(res)) {
+            Logging::info("Failed to delete backup bundle with result 0x{:08X}.", res);
+        }
+        return;
+    }
+
+    Result res = releaseBackup(path);
+    if (R_FAILED(res)) {
+        Logging::error("Failed to hand referenced files over to dependent backups with result 0x{:08X}. Keeping the backup.", res);
+        return;
+    }
+
+    res = FSUSER_DeleteDirectoryRecursively(Archive::sdmc(), fsMakePath(PATH_UTF16, path.data()));
     if (R_FAILED(res)) {
         Logging::info("Failed to delete backup folder with result 0x{:08X}.", res);
     }
@@ -25,19 +25,260 @@
  */
 
 #include "loader.hpp"
+#include "iconcache.hpp"
 #include "main.hpp"
+#include "thread.hpp"
 #include "title.hpp"
+#include "trace.hpp"
+#include "xxhash.hpp"
 #include <chrono>
 #include <mutex>
+#include <unordered_map>
 
 namespace {
-    std::vector<Title> titleSaves;
-    std::vector<Title> titleExtdatas;
+    constexpr size_t NO_TITLE = SIZE_MAX;
+
+    // every title once, the save and extdata lists hold indices into it. titleIds covers installed titles
+    // only, as a cartridge may share its id with an installed copy of the same game
+    std::vector<Title> titles;
+    std::unordered_map<u64, size_t> titleIds;
+    std::vector<size_t> titleSaves;
+    std::vector<size_t> titleExtdatas;
+    size_t cartTitle = NO_TITLE;
     std::mutex titlesMutex;
 
     bool forceRefresh           = false;
     std::atomic_flag doCartScan = ATOMIC_FLAG_INIT;
-    const size_t ENTRYSIZE      = 5341;
+
+    constexpr u32 CACHE_MAGIC   = 0x43544B43; // "CKTC"
+    constexpr u32 CACHE_VERSION = 4;
+    constexpr u32 NO_ICON       = 0xFFFFFFFF;
+    constexpr size_t ICON_UNITS = 0x900;
+
+    struct CacheHeader {
+        u32 magic;
+        u32 version;
+        u32 entries;
+        u32 saves;
+        u32 extdatas;
+        u32 stringChars;
+        u32 icons;
+        u32 known;
+        u64 checksum;
+    };
+
+    struct CacheString {
+        u32 offset;
+        u32 length;
+    };
+
+    struct CacheEntry {
+        u64 id;
+        u8 productCode[16];
+        CacheString shortDescription;
+        CacheString longDescription;
+        CacheString savePath;
+        CacheString extdataPath;
+        u32 icon;
+        u8 accessibleSave;
+        u8 accessibleExtdata;
+        u8 media;
+        u8 fsCardType;
+        u8 cardType;
+        u8 reserved[7];
+    };
+
+    static_assert(sizeof(CacheHeader) == 40 && sizeof(CacheEntry) == 72, "title cache layout must not depend on the compiler");
+
+    std::unordered_map<u64, u32> iconOffsets(const CacheEntry* entries, size_t count, u32 iconsStart)
+    {
+        std::unordered_map<u64, u32> offsets;
+        for (size_t i = 0; i < count; i++) {
+            if (entries[i].icon != NO_ICON) {
+                offsets.emplace(entries[i].id, iconsStart + entries[i].icon * ICON_UNITS * sizeof(u16));
+            }
+        }
+        return offsets;
+    }
+
+    // SD titles, and NAND titles when those are enabled
+    std::vector<std::pair<u64, FS_MediaType>> installedTitles(void)
+    {
+        std::vector<std::pair<u64, FS_MediaType>> ret;
+        for (FS_MediaType media : {MEDIATYPE_NAND, MEDIATYPE_SD}) {
+            if (media == MEDIATYPE_NAND && !Configuration::getInstance().nandSaves()) {
+                continue;
+            }
+
+            u32 count = 0;
+            u32 read  = 0;
+            AM_GetTitleCount(media, &count);
+            std::unique_ptr<u64[]> ids = std::unique_ptr<u64[]>(new u64[count]);
+            if (R_SUCCEEDED(AM_GetTitleList(&read, media, count, ids.get()))) {
+                for (u32 i = 0; i < read; i++) {
+                    ret.emplace_back(ids[i], media);
+                }
+            }
+        }
+        return ret;
+    }
+
+    const std::u16string& cachePath(void)
+    {
+        static const std::u16string path = StringUtils::UTF8toUTF16("/3ds/Checkpoint/titlecache");
+        return path;
+    }
+
+    struct ScanJob {
+        u64 id;
+        FS_MediaType media;
+        bool saves;
+        bool extdata;
+    };
+
+    struct ScanResult {
+        Title title;
+        bool save;
+        bool extdata;
+    };
+
+    // state of a cold title scan, shared by the loader and the worker tasks helping it out. a helper may only
+    // get scheduled once the scan is over, so it holds its own reference and finds no jobs left to take
+    struct TitleScan {
+        std::vector<ScanJob> jobs;
+        std::atomic<size_t> next = 0;
+        std::atomic<size_t> done = 0;
+        std::mutex mutex;
+        std::vector<ScanResult> results;
+        LightEvent finished;
+    };
+
+    void scanTitles(std::shared_ptr<TitleScan> scan)
+    {
+        std::vector<ScanResult> results;
+        size_t processed = 0;
+        for (size_t i = scan->next++; i < scan->jobs.size(); i = scan->next++) {
+            Trace::Span span("scanTitle");
+            const ScanJob& job = scan->jobs[i];
+            Title title;
+            if (title.load(job.id, job.media, CARD_CTR)) {
+                const bool save    = job.saves && title.accessibleSave();
+                const bool extdata = job.extdata && title.accessibleExtdata();
+                if (save || extdata) {
+                    results.push_back({std::move(title), save, extdata});
+                }
+            }
+
+            processed++;
+            g_loadingTitlesCounter++;
+        }
+
+        if (!results.empty()) {
+            std::lock_guard<std::mutex> lock(scan->mutex);
+            scan->results.insert(scan->results.end(), std::make_move_iterator(results.begin()), std::make_move_iterator(results.end()));
+        }
+
+        // whoever merges the last results wakes up the loader
+        if (scan->done.fetch_add(processed) + processed == scan->jobs.size()) {
+            LightEvent_Signal(&scan->finished);
+        }
+    }
+
+    struct SortKey {
+        bool favorite;
+        std::string name;
+    };
+
+    // appends an installed title to the table and to the lists it belongs in
+    void addTitle(Title&& title, bool save, bool extdata)
+    {
+        const size_t index = titles.size();
+        titleIds[title.id()] = index;
+        titles.push_back(std::move(title));
+        if (save) {
+            titleSaves.push_back(index);
+        }
+        if (extdata) {
+            titleExtdatas.push_back(index);
+        }
+    }
+
+    // drops the titles keep rejects, and their indices from both lists
+    template <typename Keep>
+    void compactTitles(Keep keep)
+    {
+        std::vector<size_t> remap(titles.size(), NO_TITLE);
+        std::vector<Title> kept;
+        kept.reserve(titles.size());
+        for (size_t i = 0; i < titles.size(); i++) {
+            if (keep(titles[i])) {
+                remap[i] = kept.size();
+                kept.push_back(std::move(titles[i]));
+            }
+        }
+
+        for (auto* list : {&titleSaves, &titleExtdatas}) {
+            std::erase_if(*list, [&remap](size_t index) { return remap[index] == NO_TITLE; });
+            for (auto& index : *list) {
+                index = remap[index];
+            }
+        }
+
+        titles = std::move(kept);
+        titleIds.clear();
+        for (size_t i = 0; i < titles.size(); i++) {
+            titleIds[titles[i].id()] = i;
+        }
+    }
+
+    // cartridges go first in the lists, there is only ever one of them. The caller holds titlesMutex
+    void insertCartTitle(Title title)
+    {
+        const bool save    = title.accessibleSave();
+        const bool extdata = title.accessibleExtdata();
+        if (cartTitle != NO_TITLE || !(save || extdata)) {
+            return;
+        }
+
+        cartTitle = titles.size();
+        titles.push_back(std::move(title));
+        if (save) {
+            titleSaves.insert(titleSaves.begin(), cartTitle);
+        }
+        if (extdata) {
+            titleExtdatas.insert(titleExtdatas.begin(), cartTitle);
+        }
+    }
+
+    // The card scanner runs on its own thread, while loadTitles rebuilds the lists without holding titlesMutex. Loading is flagged under
+    // the lock, so the scanner either finishes before a rebuild starts or leaves the lists alone until it is over; loadTitles adds the
+    // cartridge itself at the end
+    void addCartTitle(Title title)
+    {
+        std::lock_guard<std::mutex> lock(titlesMutex);
+        if (!g_isLoadingTitles) {
+            insertCartTitle(std::move(title));
+        }
+    }
+
+    void removeCartTitle(void)
+    {
+        std::lock_guard<std::mutex> lock(titlesMutex);
+        if (g_isLoadingTitles || cartTitle == NO_TITLE) {
+            return;
+        }
+
+        for (auto* list : {&titleSaves, &titleExtdatas}) {
+            if (!list->empty() && list->front() == cartTitle) {
+                list->erase(list->begin());
+            }
+        }
+        // the cartridge is added after everything else, so dropping it leaves every other index alone
+        if (cartTitle == titles.size() - 1) {
+            titles.pop_back();
+        }
+        cartTitle = NO_TITLE;
+    }
 }
 
 bool TitleLoader::validId(u64 id)
@@ -82,7 +323,7 @@ void TitleLoader::getTitle(Title& dst, int i)
     std::lock_guard<std::mutex> lock(titlesMutex);
     const auto& vec = mode == MODE_SAVE ? titleSaves : titleExtdatas;
     if (i >= 0 && i < (int)vec.size()) {
-        dst = vec.at(i);
+        dst = titles.at(vec.at(i));
     }
     else {
         dst.load();
@@ -103,7 +344,7 @@ C2D_Image TitleLoader::icon(int i)
     std::lock_guard<std::mutex> lock(titlesMutex);
     auto& vec = mode == MODE_SAVE ? titleSaves : titleExtdatas;
     if (i >= 0 && i < (int)vec.size()) {
-        return vec.at(i).icon();
+        return titles.at(vec.at(i)).icon();
     }
     return Gui::noIcon();
 }
@@ -118,239 +359,203 @@ bool TitleLoader::favorite(int i)
         if (i < 0 || i >= (int)vec.size()) {
             return false;
         }
-        id = vec.at(i).id();
+        id = titles.at(vec.at(i)).id();
     }
     return Configuration::getInstance().favorite(id);
 }
 
 void TitleLoader::refreshDirectories(u64 id)
 {
-    const Mode_t mode = Archive::mode();
     std::lock_guard<std::mutex> lock(titlesMutex);
-    if (mode == MODE_SAVE) {
-        for (size_t i = 0; i < titleSaves.size(); i++) {
-            if (titleSaves.at(i).id() == id) {
-                titleSaves.at(i).refreshDirectories();
-            }
-        }
+    auto it = titleIds.find(id);
+    if (it != titleIds.end()) {
+        titles.at(it->second).refreshDirectories();
     }
-    else {
-        for (size_t i = 0; i < titleExtdatas.size(); i++) {
-            if (titleExtdatas.at(i).id() == id) {
-                titleExtdatas.at(i).refreshDirectories();
-            }
-        }
+    if (cartTitle != NO_TITLE && titles.at(cartTitle).id() == id) {
+        titles.at(cartTitle).refreshDirectories();
     }
 }
 
 /**
- * CACHE STRUCTURE
- * start, len
- * id (0, 8)
- * productCode (8, 16)
- * accessibleSave (24, 1)
- * accessibleExtdata (25, 1)
- * shortDescription (26, 64)
- * longDescription (90, 128)
- * savePath (218, 256)
- * extdataPath (474, 256)
- * mediaType (730, 1)
- * fs cardtype (731, 1)
- * cardtype (732, 1)
- * bigIconData (733, 4608)
+ * TITLE CACHE, version 4
+ * header      CacheHeader, checksum is the XXH64 of the entries, known ids, order and strings
+ * entries     CacheEntry[entries], every title once
+ * known       u64[known], ids of all installed titles that were scanned, loaded or not. a later load only
+ *             scans the installed ids missing from here and drops the titles no longer installed
+ * order       u32[saves + extdatas], entry index of each save title, then of each extdata title
+ * strings     char16_t[stringChars], descriptions and paths, referenced by offset and length
+ * icons       u16[icons * ICON_UNITS], big SMDH icon data, referenced by index. never read on import, the
+ *             icon cache picks single icons out of it once they are drawn
  */
 
-void TitleLoader::exportTitleListCache(std::vector<Title>& list, const std::u16string& path)
-{
-    std::unique_ptr<u8[]> cache = std::unique_ptr<u8[]>(new u8[list.size() * ENTRYSIZE]());
-    for (size_t i = 0; i < list.size(); i++) {
-        u8* entryStart               = cache.get() + i * ENTRYSIZE;
-        u64 id                       = list.at(i).id();
-        bool accessibleSave          = list.at(i).accessibleSave();
-        bool accessibleExtdata       = list.at(i).accessibleExtdata();
-        std::string shortDescription = StringUtils::UTF16toUTF8(list.at(i).getShortDescription());
-        std::string longDescription  = StringUtils::UTF16toUTF8(list.at(i).getLongDescription());
-        std::string savePath         = StringUtils::UTF16toUTF8(list.at(i).savePath());
-        std::string extdataPath      = StringUtils::UTF16toUTF8(list.at(i).extdataPath());
-        FS_MediaType media           = list.at(i).mediaType();
-        FS_CardType cardType         = list.at(i).cardType();
-        CardType card                = list.at(i).SPICardType();
-
-        if (cardType == CARD_CTR) {
-            smdh_s* smdh = loadSMDH(list.at(i).lowId(), list.at(i).highId(), media);
-            if (smdh != NULL) {
-                memcpy(entryStart + 733, smdh->bigIconData, 0x900 * 2);
-            }
-            delete smdh;
-        }
-
-        memcpy(entryStart + 0, &id, sizeof(u64));
-        memcpy(entryStart + 8, list.at(i).productCode, 16);
-        memcpy(entryStart + 24, &accessibleSave, sizeof(u8));
-        memcpy(entryStart + 25, &accessibleExtdata, sizeof(u8));
-        memcpy(entryStart + 26, shortDescription.c_str(), shortDescription.length());
-        memcpy(entryStart + 90, longDescription.c_str(), longDescription.length());
-        memcpy(entryStart + 218, savePath.c_str(), savePath.length());
-        memcpy(entryStart + 474, extdataPath.c_str(), extdataPath.length());
-        memcpy(entryStart + 730, &media, sizeof(u8));
-        memcpy(entryStart + 731, &cardType, sizeof(u8));
-        memcpy(entryStart + 732, &card, sizeof(u8));
-    }
-
-    FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, path.data()));
-    FSStream output(Archive::sdmc(), path, FS_OPEN_WRITE, list.size() * ENTRYSIZE);
-    output.write(cache.get(), list.size() * ENTRYSIZE);
-    output.close();
-}
-
-void TitleLoader::importTitleListCache(void)
+size_t TitleLoader::exportTitleListCache(
+    std::vector<Title>& titles, const std::vector<size_t>& saves, const std::vector<size_t>& extdatas, const std::vector<u64>& known)
 {
-    static const std::u16string saveCachePath    = StringUtils::UTF8toUTF16("/3ds/Checkpoint/fullsavecache");
-    static const std::u16string extdataCachePath = StringUtils::UTF8toUTF16("/3ds/Checkpoint/fullextdatacache");
-
-    FSStream inputsaves(Archive::sdmc(), saveCachePath, FS_OPEN_READ);
-    u32 sizesaves = inputsaves.size() / ENTRYSIZE;
-    std::unique_ptr<u8[]> cachesaves(new u8[inputsaves.size()]);
-    inputsaves.read(cachesaves.get(), inputsaves.size());
-    inputsaves.close();
-
-    FSStream inputextdatas(Archive::sdmc(), extdataCachePath, FS_OPEN_READ);
-    u32 sizeextdatas = inputextdatas.size() / ENTRYSIZE;
-    std::unique_ptr<u8[]> cacheextdatas(new u8[inputextdatas.size()]);
-    inputextdatas.read(cacheextdatas.get(), inputextdatas.size());
-    inputextdatas.close();
-
-    g_loadingTitlesLimit = sizesaves + sizeextdatas;
-
-    titleSaves.reserve(sizesaves);
-    titleExtdatas.reserve(sizeextdatas);
-
-    // fill the lists with blank titles first
-    for (size_t i = 0, sz = std::max(sizesaves, sizeextdatas); i < sz; i++) {
-        Title title;
-        title.load();
-        if (i < sizesaves) {
-            titleSaves.push_back(title);
+    Trace::Span span("exportTitleListCache");
+    std::vector<u32> order(saves.begin(), saves.end());
+    order.insert(order.end(), extdatas.begin(), extdatas.end());
+
+    std::u16string strings;
+    auto addString = [&strings](const std::u16string& str) {
+        CacheString ret = {(u32)strings.size(), (u32)str.size()};
+        strings += str;
+        return ret;
+    };
+
+    std::vector<CacheEntry> entries(titles.size());
+    std::vector<u16> icons;
+    size_t iconsInMemory = 0;
+    for (size_t i = 0; i < titles.size(); i++) {
+        Title& title      = titles[i];
+        CacheEntry& entry = entries[i];
+
+        entry.id                = title.id();
+        entry.shortDescription  = addString(title.getShortDescription());
+        entry.longDescription   = addString(title.getLongDescription());
+        entry.savePath          = addString(title.savePath());
+        entry.extdataPath       = addString(title.extdataPath());
+        entry.icon              = NO_ICON;
+        entry.accessibleSave    = title.accessibleSave();
+        entry.accessibleExtdata = title.accessibleExtdata();
+        entry.media             = title.mediaType();
+        entry.fsCardType        = title.cardType();
+        entry.cardType          = title.SPICardType();
+        memcpy(entry.productCode, title.productCode, 16);
+
+        // titles scanned just now still hold the icon of their SMDH, titles kept from the previous cache have
+        // theirs copied out of it
+        u16 icon[ICON_UNITS];
+        if (title.iconData() != nullptr) {
+            entry.icon = icons.size() / ICON_UNITS;
+            icons.insert(icons.end(), title.iconData(), title.iconData() + ICON_UNITS);
+            iconsInMemory++;
         }
-        if (i < sizeextdatas) {
-            titleExtdatas.push_back(title);
+        else if (title.cardType() == CARD_CTR && IconCache::read(title.id(), title.mediaType(), icon)) {
+            entry.icon = icons.size() / ICON_UNITS;
+            icons.insert(icons.end(), icon, icon + ICON_UNITS);
         }
     }
 
-    // store already loaded ids
-    std::vector<u64> alreadystored;
-
-    for (size_t i = 0; i < sizesaves; i++) {
-        const u8* titleData = cachesaves.get() + i * ENTRYSIZE;
-
-        u64 id;
-        u8 productCode[16];
-        bool accessibleSave;
-        bool accessibleExtdata;
-        char shortDescription[0x40];
-        char longDescription[0x80];
-        char savePath[256];
-        char extdataPath[256];
-        FS_MediaType media;
-        FS_CardType cardType;
-        CardType card;
-
-        memcpy(&id, titleData, sizeof(u64));
-        memcpy(productCode, titleData + 8, 16);
-        memcpy(&accessibleSave, titleData + 24, sizeof(u8));
-        memcpy(&accessibleExtdata, titleData + 25, sizeof(u8));
-        memcpy(shortDescription, titleData + 26, 0x40);
-        memcpy(longDescription, titleData + 90, 0x80);
-        memcpy(savePath, titleData + 218, 256);
-        memcpy(extdataPath, titleData + 474, 256);
-        memcpy(&media, titleData + 730, sizeof(u8));
-        memcpy(&cardType, titleData + 731, sizeof(u8));
-        memcpy(&card, titleData + 732, sizeof(u8));
-
-        Title title;
-        title.load(id, productCode, accessibleSave, accessibleExtdata, StringUtils::UTF8toUTF16(shortDescription),
-            StringUtils::UTF8toUTF16(longDescription), StringUtils::UTF8toUTF16(savePath), StringUtils::UTF8toUTF16(extdataPath), media, cardType,
-            card);
-
-        if (cardType == CARD_CTR) {
-            u16 bigIconData[0x900];
-            memcpy(bigIconData, titleData + 733, 0x900 * 2);
-            C2D_Image smallIcon = loadTextureFromBytes(bigIconData);
-            title.setIcon(smallIcon);
-        }
-        else {
-            // this cannot happen
-            title.setIcon(Gui::noIcon());
-        }
+    CacheHeader header = {};
+    header.magic       = CACHE_MAGIC;
+    header.version     = CACHE_VERSION;
+    header.entries     = entries.size();
+    header.saves       = saves.size();
+    header.extdatas    = extdatas.size();
+    header.stringChars = strings.size();
+    header.icons       = icons.size() / ICON_UNITS;
+    header.known       = known.size();
+
+    const std::pair<const void*, u32> index[] = {{entries.data(), entries.size() * sizeof(CacheEntry)}, {known.data(), known.size() * sizeof(u64)},
+        {order.data(), order.size() * sizeof(u32)}, {strings.data(), strings.size() * sizeof(char16_t)}};
+    XXH64 checksum;
+    u32 iconsStart = sizeof(CacheHeader);
+    for (const auto& [data, length] : index) {
+        checksum.update(data, length);
+        iconsStart += length;
+    }
+    header.checksum = checksum.digest();
+
+    // the file is about to be replaced, icons are read from the SMDH until it is written
+    IconCache::setSource({}, {});
+
+    // the caches of the first format, and the title list hash that decided whether they were still valid,
+    // are superseded by this one
+    static const std::u16string legacySaveCache    = StringUtils::UTF8toUTF16("/3ds/Checkpoint/fullsavecache");
+    static const std::u16string legacyExtdataCache = StringUtils::UTF8toUTF16("/3ds/Checkpoint/fullextdatacache");
+    static const std::u16string legacyHash         = StringUtils::UTF8toUTF16("/3ds/Checkpoint/titles.sha");
+    FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, legacySaveCache.data()));
+    FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, legacyExtdataCache.data()));
+    FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, legacyHash.data()));
+
+    FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, cachePath().data()));
+    FSStream output(Archive::sdmc(), cachePath(), FS_OPEN_WRITE, iconsStart + icons.size() * sizeof(u16));
+    output.deferFlush();
+    output.write(&header, sizeof(CacheHeader));
+    for (const auto& [data, length] : index) {
+        output.write(data, length);
+    }
+    output.write(icons.data(), icons.size() * sizeof(u16));
+    if (R_SUCCEEDED(output.close())) {
+        IconCache::setSource(cachePath(), iconOffsets(entries.data(), entries.size(), iconsStart));
+    }
 
-        titleSaves.at(i) = title;
-        alreadystored.push_back(id);
+    return iconsInMemory;
+}
 
-        g_loadingTitlesCounter++;
+bool TitleLoader::importTitleListCache(std::vector<u64>& known)
+{
+    Trace::Span span("importTitleListCache");
+    FSStream input(Archive::sdmc(), cachePath(), FS_OPEN_READ);
+    CacheHeader header;
+    if (!input.good() || input.read(&header, sizeof(CacheHeader)) != sizeof(CacheHeader) || header.magic != CACHE_MAGIC ||
+        header.version != CACHE_VERSION) {
+        input.close();
+        Logging::warning("Title cache is missing or of another version, rescanning titles.");
+        return false;
     }
 
-    for (size_t i = 0; i < sizeextdatas; i++) {
-        const u8* titleData = cacheextdatas.get() + i * ENTRYSIZE;
-
-        u64 id;
-        memcpy(&id, titleData, sizeof(u64));
-        std::vector<u64>::iterator it = find(alreadystored.begin(), alreadystored.end(), id);
-        if (it == alreadystored.end()) {
-            u8 productCode[16];
-            bool accessibleSave;
-            bool accessibleExtdata;
-            char shortDescription[0x40];
-            char longDescription[0x80];
-            char savePath[256];
-            char extdataPath[256];
-            FS_MediaType media;
-            FS_CardType cardType;
-            CardType card;
-
-            memcpy(productCode, titleData + 8, 16);
-            memcpy(&accessibleSave, titleData + 24, sizeof(u8));
-            memcpy(&accessibleExtdata, titleData + 25, sizeof(u8));
-            memcpy(shortDescription, titleData + 26, 0x40);
-            memcpy(longDescription, titleData + 90, 0x80);
-            memcpy(savePath, titleData + 218, 256);
-            memcpy(extdataPath, titleData + 474, 256);
-            memcpy(&media, titleData + 730, sizeof(u8));
-            memcpy(&cardType, titleData + 731, sizeof(u8));
-            memcpy(&card, titleData + 732, sizeof(u8));
+    const u64 entriesSize = (u64)header.entries * sizeof(CacheEntry);
+    const u64 knownSize   = (u64)header.known * sizeof(u64);
+    const u64 orderSize   = ((u64)header.saves + header.extdatas) * sizeof(u32);
+    const u64 stringsSize = (u64)header.stringChars * sizeof(char16_t);
+    const u64 iconsSize   = (u64)header.icons * ICON_UNITS * sizeof(u16);
+    const u64 indexSize   = entriesSize + knownSize + orderSize + stringsSize;
+    if (sizeof(CacheHeader) + indexSize + iconsSize != input.size()) {
+        input.close();
+        Logging::warning("Title cache has the wrong size, rescanning titles.");
+        return false;
+    }
 
-            Title title;
-            title.load(id, productCode, accessibleSave, accessibleExtdata, StringUtils::UTF8toUTF16(shortDescription),
-                StringUtils::UTF8toUTF16(longDescription), StringUtils::UTF8toUTF16(savePath), StringUtils::UTF8toUTF16(extdataPath), media, cardType,
-                card);
+    // u64 storage keeps the entry table aligned, so everything up to the icons is used in place
+    std::unique_ptr<u64[]> buffer(new u64[(indexSize + 7) / 8]);
+    u8* data       = reinterpret_cast<u8*>(buffer.get());
+    const u32 read = input.read(data, indexSize);
+    input.close();
+    if (read != indexSize || XXH64::hash(data, indexSize) != header.checksum) {
+        Logging::warning("Title cache doesn't match its checksum, rescanning titles.");
+        return false;
+    }
 
-            if (cardType == CARD_CTR) {
-                u16 bigIconData[0x900];
-                memcpy(bigIconData, titleData + 733, 0x900 * 2);
-                C2D_Image smallIcon = loadTextureFromBytes(bigIconData);
-                title.setIcon(smallIcon);
-            }
-            else {
-                // this cannot happen
-                title.setIcon(Gui::noIcon());
-            }
+    CacheEntry* entries     = reinterpret_cast<CacheEntry*>(data);
+    const u64* knownIds     = reinterpret_cast<const u64*>(data + entriesSize);
+    const u32* order        = reinterpret_cast<const u32*>(data + entriesSize + knownSize);
+    const char16_t* strings = reinterpret_cast<const char16_t*>(data + entriesSize + knownSize + orderSize);
 
-            titleExtdatas.at(i) = title;
+    auto inRange = [&header](const CacheString& str) { return (u64)str.offset + str.length <= header.stringChars; };
+    auto string  = [strings](const CacheString& str) { return std::u16string(strings + str.offset, str.length); };
 
-            g_loadingTitlesCounter++;
+    // validate every reference up front, so a bad cache never yields a partial title list
+    for (u32 i = 0; i < header.entries; i++) {
+        const CacheEntry& entry = entries[i];
+        if (!inRange(entry.shortDescription) || !inRange(entry.longDescription) || !inRange(entry.savePath) || !inRange(entry.extdataPath) ||
+            (entry.icon != NO_ICON && entry.icon >= header.icons)) {
+            Logging::warning("Title cache entry {} is out of bounds, rescanning titles.", i);
+            return false;
         }
-        else {
-            auto pos = it - alreadystored.begin();
+    }
+    if (std::any_of(order, order + header.saves + header.extdatas, [&header](u32 index) { return index >= header.entries; })) {
+        Logging::warning("Title cache order is out of bounds, rescanning titles.");
+        return false;
+    }
 
-            // avoid to copy a cartridge title into the extdata list twice
-            if (i != 0 && pos == 0) {
-                auto newpos         = find(alreadystored.rbegin(), alreadystored.rend(), id);
-                titleExtdatas.at(i) = titleSaves.at(alreadystored.rend() - newpos - 1);
-            }
-            else {
-                titleExtdatas.at(i) = titleSaves.at(pos);
-            }
-        }
+    // the entry table is the title table, the order table is both lists
+    titles.resize(header.entries);
+    titleIds.reserve(header.entries);
+    for (u32 i = 0; i < header.entries; i++) {
+        CacheEntry& entry = entries[i];
+        titles[i].load(entry.id, entry.productCode, entry.accessibleSave, entry.accessibleExtdata, string(entry.shortDescription),
+            string(entry.longDescription), string(entry.savePath), (FS_MediaType)entry.media, (FS_CardType)entry.fsCardType,
+            (CardType)entry.cardType);
+        titleIds[entry.id] = i;
     }
+
+    titleSaves.assign(order, order + header.saves);
+    titleExtdatas.assign(order + header.saves, order + header.saves + header.extdatas);
+    known.assign(knownIds, knownIds + header.known);
+
+    IconCache::setSource(cachePath(), iconOffsets(entries, header.entries, sizeof(CacheHeader) + indexSize));
+    return true;
 }
 
 bool TitleLoader::scanCard(void)
@@ -382,18 +587,7 @@ bool TitleLoader::scanCard(void)
                     Title title;
                     if (title.load(id, MEDIATYPE_GAME_CARD, cardType)) {
                         ret = true;
-                        if (title.accessibleSave()) {
-                            std::lock_guard<std::mutex> lock(titlesMutex);
-                            if (titleSaves.empty() || titleSaves.at(0).mediaType() != MEDIATYPE_GAME_CARD) {
-                                titleSaves.insert(titleSaves.begin(), title);
-                            }
-                        }
-                        if (title.accessibleExtdata()) {
-                            std::lock_guard<std::mutex> lock(titlesMutex);
-                            if (titleExtdatas.empty() || titleExtdatas.at(0).mediaType() != MEDIATYPE_GAME_CARD) {
-                                titleExtdatas.insert(titleExtdatas.begin(), title);
-                            }
-                        }
+                        addCartTitle(title);
                     }
                 }
             }
@@ -402,10 +596,7 @@ bool TitleLoader::scanCard(void)
             Title title;
             if (title.load(0, MEDIATYPE_GAME_CARD, cardType)) {
                 ret = true;
-                std::lock_guard<std::mutex> lock(titlesMutex);
-                if (titleSaves.empty() || titleSaves.at(0).mediaType() != MEDIATYPE_GAME_CARD) {
-                    titleSaves.insert(titleSaves.begin(), title);
-                }
+                addCartTitle(title);
             }
         }
     }
@@ -441,15 +632,7 @@ void TitleLoader::cartScan(void)
             }
             else {
                 FSUSER_CardSlotPowerOff(&power);
-                if (!g_isLoadingTitles) {
-                    std::lock_guard<std::mutex> lock(titlesMutex);
-                    if (!titleSaves.empty() && titleSaves.at(0).mediaType() == MEDIATYPE_GAME_CARD) {
-                        titleSaves.erase(titleSaves.begin());
-                    }
-                    if (!titleExtdatas.empty() && titleExtdatas.at(0).mediaType() == MEDIATYPE_GAME_CARD) {
-                        titleExtdatas.erase(titleExtdatas.begin());
-                    }
-                }
+                removeCartTitle();
                 oldCardIn = false;
             }
         }
@@ -458,183 +641,128 @@ void TitleLoader::cartScan(void)
 
 void TitleLoader::loadTitles(bool forceRefreshParam)
 {
+    Trace::Span span("loadTitles");
     auto totalStart   = std::chrono::high_resolution_clock::now();
     auto sectionStart = totalStart;
     try {
-        static const std::u16string savecachePath    = StringUtils::UTF8toUTF16("/3ds/Checkpoint/fullsavecache");
-        static const std::u16string extdatacachePath = StringUtils::UTF8toUTF16("/3ds/Checkpoint/fullextdatacache");
-
+        titles.clear();
+        titleIds.clear();
         titleSaves.clear();
         titleExtdatas.clear();
-        titleSaves.reserve(128);
-        titleExtdatas.reserve(128);
-
-        bool optimizedLoad = false;
-
-        u8 hash[SHA256_BLOCK_SIZE];
-        calculateTitleDBHash(hash);
-
-        std::u16string titlesHashPath = StringUtils::UTF8toUTF16("/3ds/Checkpoint/titles.sha");
-        if (!io::fileExists(Archive::sdmc(), titlesHashPath) || !io::fileExists(Archive::sdmc(), savecachePath) ||
-            !io::fileExists(Archive::sdmc(), extdatacachePath)) {
-            // create title list sha256 hash file if it doesn't exist in the working directory
-            FSStream output(Archive::sdmc(), titlesHashPath, FS_OPEN_WRITE, SHA256_BLOCK_SIZE);
-            output.write(hash, SHA256_BLOCK_SIZE);
-            output.close();
-        }
-        else {
-            // compare current hash with the previous hash
-            FSStream input(Archive::sdmc(), titlesHashPath, FS_OPEN_READ);
-            if (input.good() && input.size() == SHA256_BLOCK_SIZE) {
-                u8* buf = new u8[input.size()];
-                input.read(buf, input.size());
-                input.close();
-
-                if (memcmp(hash, buf, SHA256_BLOCK_SIZE) == 0) {
-                    // hash matches
-                    optimizedLoad = true;
-                }
-                else {
-                    FSUSER_DeleteFile(Archive::sdmc(), fsMakePath(PATH_UTF16, titlesHashPath.data()));
-                    FSStream output(Archive::sdmc(), titlesHashPath, FS_OPEN_WRITE, SHA256_BLOCK_SIZE);
-                    output.write(hash, SHA256_BLOCK_SIZE);
-                    output.close();
-                }
-
-                delete[] buf;
-            }
-        }
-
-        if (optimizedLoad && !forceRefreshParam) {
-            g_loadingTitlesCounter = 0;
+        cartTitle = NO_TITLE;
 
+        // the ids the cache has already seen, everything else installed is new and gets scanned
+        std::vector<u64> known;
+        bool cached = false;
+        if (!forceRefreshParam) {
             sectionStart = std::chrono::high_resolution_clock::now();
-            // deserialize data
-            importTitleListCache();
+            // deserialize data, a cache that can't be used leaves known empty and everything is scanned
+            cached = importTitleListCache(known);
 
             auto importEnd      = std::chrono::high_resolution_clock::now();
             auto importDuration = std::chrono::duration_cast<std::chrono::milliseconds>(importEnd - sectionStart);
             Logging::debug("Title cache import completed in {} ms", importDuration.count());
-
-            g_loadingTitlesCounter = titleSaves.size() + titleExtdatas.size();
-
-            sectionStart = std::chrono::high_resolution_clock::now();
-
-            for (auto& title : titleSaves) {
-                title.refreshDirectories();
-            }
-            for (auto& title : titleExtdatas) {
-                title.refreshDirectories();
-            }
-
-            auto refreshEnd      = std::chrono::high_resolution_clock::now();
-            auto refreshDuration = std::chrono::duration_cast<std::chrono::milliseconds>(refreshEnd - sectionStart);
-            Logging::debug("Directory refresh completed in {} ms", refreshDuration.count());
         }
-        else {
-            u32 count     = 0;
-            u32 nandCount = 0;
-            u32 sdCount   = 0;
-            u32 cartCount = 0;
+        std::sort(known.begin(), known.end());
 
-            if (Configuration::getInstance().nandSaves()) {
-                AM_GetTitleCount(MEDIATYPE_NAND, &nandCount);
-            }
-
-            AM_GetTitleCount(MEDIATYPE_SD, &sdCount);
-            AM_GetTitleCount(MEDIATYPE_GAME_CARD, &cartCount);
+        const auto installed = installedTitles();
+        u32 cartCount        = 0;
+        AM_GetTitleCount(MEDIATYPE_GAME_CARD, &cartCount);
 
-            g_loadingTitlesLimit   = nandCount + sdCount + cartCount;
-            g_loadingTitlesCounter = 0;
+        g_loadingTitlesLimit   = installed.size() + cartCount;
+        g_loadingTitlesCounter = 0;
 
-            if (Configuration::getInstance().nandSaves()) {
-                AM_GetTitleCount(MEDIATYPE_NAND, &count);
-                std::unique_ptr<u64[]> ids_nand = std::unique_ptr<u64[]>(new u64[count]);
-                AM_GetTitleList(NULL, MEDIATYPE_NAND, count, ids_nand.get());
+        sectionStart = std::chrono::high_resolution_clock::now();
 
-                for (u32 i = 0; i < count; i++) {
-                    if (validId(ids_nand[i])) {
-                        Title title;
-                        if (title.load(ids_nand[i], MEDIATYPE_NAND, CARD_CTR)) {
-                            if (title.accessibleSave()) {
-                                titleSaves.push_back(title);
-                            }
-                            // TODO: extdata?
-                        }
-                    }
+        auto scan = std::make_shared<TitleScan>();
+        LightEvent_Init(&scan->finished, RESET_STICKY);
 
-                    g_loadingTitlesCounter++;
-                }
+        std::vector<u64> scanned;
+        for (const auto& [id, media] : installed) {
+            if (!validId(id)) {
+                g_loadingTitlesCounter++;
+                continue;
             }
 
-            count = 0;
-            AM_GetTitleCount(MEDIATYPE_SD, &count);
-            std::unique_ptr<u64[]> ids = std::unique_ptr<u64[]>(new u64[count]);
-            AM_GetTitleList(NULL, MEDIATYPE_SD, count, ids.get());
-
-            for (u32 i = 0; i < count; i++) {
-                if (validId(ids[i])) {
-                    Title title;
-                    if (title.load(ids[i], MEDIATYPE_SD, CARD_CTR)) {
-                        if (title.accessibleSave()) {
-                            titleSaves.push_back(title);
-                        }
-
-                        if (title.accessibleExtdata()) {
-                            titleExtdatas.push_back(title);
-                        }
-                    }
-                }
-
+            scanned.push_back(id);
+            if (std::binary_search(known.begin(), known.end(), id)) {
                 g_loadingTitlesCounter++;
             }
-
-            // always check for PKSM's extdata archive
-            bool isPKSMIdAlreadyHere = false;
-            for (u32 i = 0; i < count; i++) {
-                if (ids[i] == TID_PKSM) {
-                    isPKSMIdAlreadyHere = true;
-                    break;
-                }
+            else {
+                // TODO: extdata for NAND titles?
+                scan->jobs.push_back({id, media, true, media != MEDIATYPE_NAND});
             }
-            if (!isPKSMIdAlreadyHere) {
-                Title title;
-                if (title.load(TID_PKSM, MEDIATYPE_SD, CARD_CTR)) {
-                    if (title.accessibleExtdata()) {
-                        titleExtdatas.push_back(title);
-                    }
-                }
+        }
+        std::sort(scanned.begin(), scanned.end());
+
+        // cached titles that were uninstalled or filtered out since go away. so does the extdata of a PKSM that
+        // isn't installed, which is looked up through the romfs SMDH on every load
+        auto keep = [&known, &scanned](u64 id) {
+            return std::binary_search(known.begin(), known.end(), id) && std::binary_search(scanned.begin(), scanned.end(), id);
+        };
+        compactTitles([&keep](Title& title) { return keep(title.id()); });
+        const size_t added   = scan->jobs.size();
+        const size_t removed = std::count_if(known.begin(), known.end(), [&keep](u64 id) { return !keep(id); });
+        if (!std::binary_search(scanned.begin(), scanned.end(), TID_PKSM)) {
+            scan->jobs.push_back({TID_PKSM, MEDIATYPE_SD, false, true});
+        }
 
-                g_loadingTitlesCounter++;
-            }
+        for (auto& title : titles) {
+            title.refreshDirectories();
         }
 
-        std::sort(titleSaves.begin(), titleSaves.end(), [](Title& l, Title& r) {
-            if (Configuration::getInstance().favorite(l.id()) != Configuration::getInstance().favorite(r.id())) {
-                return Configuration::getInstance().favorite(l.id());
-            }
-            else {
-                return l.shortDescription() < r.shortDescription();
-            }
-        });
+        const u64 smdhStart = smdhReadTime();
 
-        std::sort(titleExtdatas.begin(), titleExtdatas.end(), [](Title& l, Title& r) {
-            if (Configuration::getInstance().favorite(l.id()) != Configuration::getInstance().favorite(r.id())) {
-                return Configuration::getInstance().favorite(l.id());
+        // this thread is a worker already, so it takes jobs alongside the helpers instead of idling
+        for (int i = 1; i < Threads::workerLimit() && (size_t)i < scan->jobs.size(); i++) {
+            Threads::executeTask(scanTitles, scan);
+        }
+        scanTitles(scan);
+        LightEvent_Wait(&scan->finished);
+
+        {
+            std::lock_guard<std::mutex> lock(scan->mutex);
+            titles.reserve(titles.size() + scan->results.size());
+            for (auto& result : scan->results) {
+                addTitle(std::move(result.title), result.save, result.extdata);
             }
-            else {
-                return l.shortDescription() < r.shortDescription();
+        }
+
+        auto scanEnd      = std::chrono::high_resolution_clock::now();
+        auto scanDuration = std::chrono::duration_cast<std::chrono::milliseconds>(scanEnd - sectionStart);
+        const u64 smdhMs  = (smdhReadTime() - smdhStart) / 1000;
+        Logging::debug("Title scan of {} added and {} removed titles on {} workers completed in {} ms ({} ms of SMDH reads summed across workers)",
+            added, removed, Threads::workerLimit(), scanDuration.count(), smdhMs);
+
+        // one key per title, so comparing two titles neither looks up favorites nor converts descriptions
+        std::vector<SortKey> keys;
+        keys.reserve(titles.size());
+        for (auto& title : titles) {
+            keys.push_back({Configuration::getInstance().favorite(title.id()), title.shortDescription()});
+        }
+        auto byFavoriteAndName = [&keys](size_t l, size_t r) {
+            if (keys[l].favorite != keys[r].favorite) {
+                return keys[l].favorite;
             }
-        });
+            return keys[l].name < keys[r].name;
+        };
+        std::sort(titleSaves.begin(), titleSaves.end(), byFavoriteAndName);
+        std::sort(titleExtdatas.begin(), titleExtdatas.end(), byFavoriteAndName);
 
-        if (!optimizedLoad || forceRefreshParam) {
+        if (!cached || added > 0 || removed > 0) {
             auto exportStart = std::chrono::high_resolution_clock::now();
             Logging::debug("Starting title cache export");
-            exportTitleListCache(titleSaves, savecachePath);
-            exportTitleListCache(titleExtdatas, extdatacachePath);
+            const size_t reused = exportTitleListCache(titles, titleSaves, titleExtdatas, scanned);
             auto exportEnd      = std::chrono::high_resolution_clock::now();
             auto exportDuration = std::chrono::duration_cast<std::chrono::milliseconds>(exportEnd - exportStart);
-            Logging::debug("Title cache export completed in {} ms", exportDuration.count());
+            // every icon reused from the scan is an SMDH that would have been read a second time
+            const u64 savedMs = scan->jobs.empty() ? 0 : smdhMs * reused / scan->jobs.size();
+            Logging::debug("Title cache export completed in {} ms, {} icons reused from the scan saved about {} ms of SMDH reads",
+                exportDuration.count(), reused, savedMs);
+        }
+
+        for (auto& title : titles) {
+            title.releaseIconData();
         }
 
         FS_CardType cardType;
@@ -649,13 +777,8 @@ void TitleLoader::loadTitles(bool forceRefreshParam)
                     if (validId(ids[0])) {
                         Title title;
                         if (title.load(ids[0], MEDIATYPE_GAME_CARD, cardType)) {
-                            if (title.accessibleSave()) {
-                                titleSaves.insert(titleSaves.begin(), title);
-                            }
-
-                            if (title.accessibleExtdata()) {
-                                titleExtdatas.insert(titleExtdatas.begin(), title);
-                            }
+                            std::lock_guard<std::mutex> lock(titlesMutex);
+                            insertCartTitle(title);
                         }
                     }
                     g_loadingTitlesCounter++;
@@ -664,7 +787,8 @@ void TitleLoader::loadTitles(bool forceRefreshParam)
             else {
                 Title title;
                 if (title.load(0, MEDIATYPE_GAME_CARD, cardType)) {
-                    titleSaves.insert(titleSaves.begin(), title);
+                    std::lock_guard<std::mutex> lock(titlesMutex);
+                    insertCartTitle(title);
                 }
                 g_loadingTitlesCounter++;
             }
@@ -684,12 +808,15 @@ void TitleLoader::loadTitles(bool forceRefreshParam)
 
 void TitleLoader::loadTitlesThread(void)
 {
-    // don't load titles while they're loading
-    if (g_isLoadingTitles) {
-        return;
+    // don't load titles while they're loading. The flag is set under titlesMutex, see addCartTitle
+    {
+        std::lock_guard<std::mutex> lock(titlesMutex);
+        if (g_isLoadingTitles) {
+            return;
+        }
+        g_isLoadingTitles = true;
     }
 
-    g_isLoadingTitles      = true;
     g_loadingTitlesCounter = 0;
     g_loadingTitlesLimit   = 0;
 
@@ -26,13 +26,15 @@
 
 #include "main.hpp"
 #include "MainScreen.hpp"
+#include "job.hpp"
 #include "thread.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 #include <chrono>
 
 int main()
 {
-    auto start = std::chrono::high_resolution_clock::now();
+    auto start = std::chrono::steady_clock::now();
 
     Result res;
     try {
@@ -54,7 +56,8 @@ int main()
 
     try {
         g_screen       = std::make_unique<MainScreen>();
-        auto uiIsReady = std::chrono::high_resolution_clock::now();
+        auto uiIsReady = std::chrono::steady_clock::now();
+        Trace::record("startup", start, uiIsReady);
         Logging::info("Loading took {} ms", std::chrono::duration_cast<std::chrono::milliseconds>(uiIsReady - start).count());
 
         while (aptMainLoop()) {
@@ -63,17 +66,25 @@ int main()
             hidTouchRead(&touch);
 
             if (hidKeysDown() & KEY_START) {
-                if (!g_isLoadingTitles) {
+                if (!g_isLoadingTitles && !Job::running()) {
                     break;
                 }
             }
 
-            C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
-            g_screen->doDrawTop();
-            C2D_SceneBegin(g_bottom);
-            g_screen->doDrawBottom();
-            Gui::frameEnd();
+            if (g_screen->frameDue(hidKeysDown() || hidKeysHeld() || hidKeysUp())) {
+                C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
+                g_screen->doDrawTop();
+                C2D_SceneBegin(g_bottom);
+                g_screen->doDrawBottom();
+                Gui::frameEnd();
+            }
+            else {
+                // the last frame stays on screen, only the pace of the loop is kept
+                gspWaitForVBlank();
+            }
             g_screen->doUpdate(InputState{touch});
+            // pulsing outlines follow the loop, not the frames that were actually drawn
+            g_timer += 0.025f;
         }
     }
     catch (const std::exception& e) {
@@ -25,9 +25,24 @@
  */
 
 #include "smdh.hpp"
+#include "trace.hpp"
+#include <atomic>
+#include <chrono>
+
+namespace {
+    std::atomic<u64> readTime = 0;
+
+    // adds the lifetime of the enclosing loadSMDH call to readTime, whichever way it returns
+    struct ReadTimer {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        ~ReadTimer() { readTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count(); }
+    };
+}
 
 smdh_s* loadSMDH(u32 low, u32 high, u8 media)
 {
+    Trace::Span span("loadSMDH");
+    ReadTimer timer;
     Handle fileHandle;
 
     u32 archPath[]              = {low, high, media, 0x0};
@@ -53,6 +68,7 @@ smdh_s* loadSMDH(u32 low, u32 high, u8 media)
 
 smdh_s* loadSMDH(const std::string& path)
 {
+    ReadTimer timer;
     FILE* f = fopen(path.c_str(), "rb");
     if (f != NULL) {
         smdh_s* smdh = new smdh_s;
@@ -61,4 +77,9 @@ smdh_s* loadSMDH(const std::string& path)
         return smdh;
     }
     return NULL;
+}
+
+u64 smdhReadTime(void)
+{
+    return readTime;
 }
\ No newline at end of file
@@ -188,6 +188,11 @@ void Threads::executeTask(void (*task)(void*), void* arg)
     }
 }
 
+u8 Threads::workerLimit(void)
+{
+    return maxWorkers;
+}
+
 void Threads::exit(void)
 {
     workerTasks.lock()->clear();
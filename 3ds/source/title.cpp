@@ -25,36 +25,18 @@
  */
 
 #include "title.hpp"
+#include "bundle.hpp"
+#include "iconcache.hpp"
 #include "loader.hpp"
 #include "main.hpp"
+#include "trace.hpp"
 #include <chrono>
 
+static constexpr u16 NEW_BACKUP = 0xFFFF;
+
 static constexpr Tex3DS_SubTexture dsIconSubt3x = {32, 32, 0.0f, 1.0f, 1.0f, 0.0f};
 static C2D_Image dsIcon                         = {nullptr, &dsIconSubt3x};
 
-C2D_Image loadTextureFromBytes(u16* bigIconData)
-{
-    C3D_Tex* tex                          = (C3D_Tex*)malloc(sizeof(C3D_Tex));
-    static const Tex3DS_SubTexture subt3x = {48, 48, 0.0f, 48 / 64.0f, 48 / 64.0f, 0.0f};
-    C2D_Image image                       = (C2D_Image){tex, &subt3x};
-    C3D_TexInit(image.tex, 64, 64, GPU_RGB565);
-
-    u16* dest = (u16*)image.tex->data + (64 - 48) * 64;
-    u16* src  = bigIconData;
-    for (int j = 0; j < 48; j += 8) {
-        memcpy(dest, src, 48 * 8 * sizeof(u16));
-        src += 48 * 8;
-        dest += 64 * 8;
-    }
-
-    return image;
-}
-
-static C2D_Image loadTextureIcon(smdh_s* smdh)
-{
-    return loadTextureFromBytes(smdh->bigIconData);
-}
-
 static void loadDSIcon(u8* banner)
 {
     static constexpr int WIDTH_POW2  = 32;
@@ -101,30 +83,31 @@ void Title::load(void)
     mMedia = MEDIATYPE_SD;
     mCard  = CARD_CTR;
     memset(productCode, 0, 16);
-    mShortDescription  = StringUtils::UTF8toUTF16("");
-    mLongDescription   = StringUtils::UTF8toUTF16("");
-    mSavePath          = StringUtils::UTF8toUTF16("");
-    mExtdataPath       = StringUtils::UTF8toUTF16("");
+    setStrings(u"", u"", u"");
     mAccessibleSave    = false;
     mAccessibleExtdata = false;
+    mIcon              = {};
+    mIconData.reset();
     mSaves.clear();
+    mSaveFolders.clear();
     mExtdata.clear();
+    mExtdataFolders.clear();
 }
 
 void Title::load(u64 id, u8* _productCode, bool accessibleSave, bool accessibleExtdata, std::u16string shortDescription,
-    std::u16string longDescription, std::u16string savePath, std::u16string extdataPath, FS_MediaType media, FS_CardType cardType, CardType card)
+    std::u16string longDescription, std::u16string savePath, FS_MediaType media, FS_CardType cardType, CardType card)
 {
     mId                = id;
     mAccessibleSave    = accessibleSave;
     mAccessibleExtdata = accessibleExtdata;
-    mShortDescription  = shortDescription;
-    mLongDescription   = longDescription;
-    mSavePath          = savePath;
-    mExtdataPath       = extdataPath;
     mMedia             = media;
     mCard              = cardType;
     mCardType          = card;
+    mIcon              = {};
+    mIconData.reset();
 
+    // the save and extdata paths end in the same folder name, which is all that is kept
+    setStrings(shortDescription, longDescription, savePath.substr(savePath.find_last_of(u'/') + 1));
     memcpy(productCode, _productCode, 16);
 }
 
@@ -134,6 +117,8 @@ bool Title::load(u64 _id, FS_MediaType _media, FS_CardType _card)
     mId            = _id;
     mMedia         = _media;
     mCard          = _card;
+    mIcon          = {};
+    mIconData.reset();
 
     if (mCard == CARD_CTR) {
         smdh_s* smdh;
@@ -151,10 +136,8 @@ bool Title::load(u64 _id, FS_MediaType _media, FS_CardType _card)
         char unique[12] = {0};
         sprintf(unique, "0x%05X ", (unsigned int)uniqueId());
 
-        mShortDescription = StringUtils::removeForbiddenCharacters((char16_t*)smdh->applicationTitles[1].shortDescription);
-        mLongDescription  = (char16_t*)smdh->applicationTitles[1].longDescription;
-        mSavePath         = StringUtils::UTF8toUTF16("/3ds/Checkpoint/saves/") + StringUtils::UTF8toUTF16(unique) + mShortDescription;
-        mExtdataPath      = StringUtils::UTF8toUTF16("/3ds/Checkpoint/extdata/") + StringUtils::UTF8toUTF16(unique) + mShortDescription;
+        std::u16string shortDescription = StringUtils::removeForbiddenCharacters((char16_t*)smdh->applicationTitles[1].shortDescription);
+        setStrings(shortDescription, (char16_t*)smdh->applicationTitles[1].longDescription, StringUtils::UTF8toUTF16(unique) + shortDescription);
         AM_GetTitleProductCode(mMedia, mId, productCode);
 
         mAccessibleSave    = Archive::accessible(mediaType(), lowId(), highId());
@@ -162,8 +145,8 @@ bool Title::load(u64 _id, FS_MediaType _media, FS_CardType _card)
 
         if (mAccessibleSave) {
             loadTitle = true;
-            if (!io::directoryExists(Archive::sdmc(), mSavePath)) {
-                Result res = io::createDirectory(Archive::sdmc(), mSavePath);
+            if (!io::directoryExists(Archive::sdmc(), savePath())) {
+                Result res = io::createDirectory(Archive::sdmc(), savePath());
                 if (R_FAILED(res)) {
                     loadTitle = false;
                     Logging::error("Failed to create backup directory with result 0x{:08X}.", res);
@@ -173,8 +156,8 @@ bool Title::load(u64 _id, FS_MediaType _media, FS_CardType _card)
 
         if (mAccessibleExtdata) {
             loadTitle = true;
-            if (!io::directoryExists(Archive::sdmc(), mExtdataPath)) {
-                Result res = io::createDirectory(Archive::sdmc(), mExtdataPath);
+            if (!io::directoryExists(Archive::sdmc(), extdataPath())) {
+                Result res = io::createDirectory(Archive::sdmc(), extdataPath());
                 if (R_FAILED(res)) {
                     loadTitle = false;
                     Logging::error("Failed to create backup directory with result 0x{:08X}.", res);
@@ -183,7 +166,8 @@ bool Title::load(u64 _id, FS_MediaType _media, FS_CardType _card)
         }
 
         if (loadTitle) {
-            mIcon = loadTextureIcon(smdh);
+            mIconData = std::shared_ptr<u16[]>(new u16[0x900]);
+            memcpy(mIconData.get(), smdh->bigIconData, sizeof(smdh->bigIconData));
         }
 
         delete smdh;
@@ -218,19 +202,16 @@ bool Title::load(u64 _id, FS_MediaType _media, FS_CardType _card)
             return false;
         }
 
-        mShortDescription = StringUtils::removeForbiddenCharacters(StringUtils::UTF8toUTF16(_cardTitle));
-        mLongDescription  = mShortDescription;
-        mSavePath         = StringUtils::UTF8toUTF16("/3ds/Checkpoint/saves/") + StringUtils::UTF8toUTF16(_gameCode) + StringUtils::UTF8toUTF16(" ") +
-                    mShortDescription;
-        mExtdataPath = mSavePath;
+        std::u16string shortDescription = StringUtils::removeForbiddenCharacters(StringUtils::UTF8toUTF16(_cardTitle));
+        setStrings(shortDescription, shortDescription, StringUtils::UTF8toUTF16(_gameCode) + StringUtils::UTF8toUTF16(" ") + shortDescription);
         memset(productCode, 0, 16);
 
         mAccessibleSave    = true;
         mAccessibleExtdata = false;
 
         loadTitle = true;
-        if (!io::directoryExists(Archive::sdmc(), mSavePath)) {
-            res = io::createDirectory(Archive::sdmc(), mSavePath);
+        if (!io::directoryExists(Archive::sdmc(), savePath())) {
+            res = io::createDirectory(Archive::sdmc(), savePath());
             if (R_FAILED(res)) {
                 loadTitle = false;
                 Logging::error("Failed to create backup directory with result 0x{:08X}.", res);
@@ -270,44 +251,77 @@ std::string Title::mediaTypeString(void)
     return " ";
 }
 
+void Title::setStrings(const std::u16string& shortDescription, const std::u16string& longDescription, const std::u16string& folder)
+{
+    auto strings = std::make_shared<std::u16string>();
+    strings->reserve(shortDescription.size() + longDescription.size() + folder.size());
+    strings->append(shortDescription).append(longDescription).append(folder);
+    mLongOffset   = shortDescription.size();
+    mFolderOffset = mLongOffset + longDescription.size();
+    mStrings      = std::move(strings);
+}
+
+std::u16string Title::string(size_t begin, size_t end)
+{
+    return mStrings ? mStrings->substr(begin, end - begin) : std::u16string();
+}
+
+std::u16string Title::folder(void)
+{
+    return string(mFolderOffset, std::u16string::npos);
+}
+
 std::string Title::shortDescription(void)
 {
-    return StringUtils::UTF16toUTF8(mShortDescription);
+    return StringUtils::UTF16toUTF8(getShortDescription());
 }
 
 std::u16string Title::getShortDescription(void)
 {
-    return mShortDescription;
+    return string(0, mLongOffset);
 }
 
 std::string Title::longDescription(void)
 {
-    return StringUtils::UTF16toUTF8(mLongDescription);
+    return StringUtils::UTF16toUTF8(getLongDescription());
 }
 
 std::u16string Title::getLongDescription(void)
 {
-    return mLongDescription;
+    return string(mLongOffset, mFolderOffset);
 }
 
 std::u16string Title::savePath(void)
 {
-    return mSavePath;
+    std::u16string name = folder();
+    return name.empty() ? name : StringUtils::UTF8toUTF16("/3ds/Checkpoint/saves/") + name;
 }
 
 std::u16string Title::extdataPath(void)
 {
-    return mExtdataPath;
+    // DS cartridges have no extdata, their extdata path has always been the save path
+    std::u16string name = folder();
+    return name.empty() || mCard != CARD_CTR ? savePath() : StringUtils::UTF8toUTF16("/3ds/Checkpoint/extdata/") + name;
+}
+
+static std::u16string backupPath(const std::u16string& root, const std::vector<std::u16string>& additionalFolders,
+    const std::vector<std::u16string>& names, const std::vector<u16>& folders, size_t index)
+{
+    const u16 folder = folders.at(index);
+    if (folder == NEW_BACKUP) {
+        return names.at(index);
+    }
+    return (folder == 0 ? root : additionalFolders.at(folder - 1)) + StringUtils::UTF8toUTF16("/") + names.at(index);
 }
 
 std::u16string Title::fullSavePath(size_t index)
 {
-    return mFullSavePaths.at(index);
+    return backupPath(savePath(), mAdditionalSaveFolders, mSaves, mSaveFolders, index);
 }
 
 std::u16string Title::fullExtdataPath(size_t index)
 {
-    return mFullExtdataPaths.at(index);
+    return backupPath(extdataPath(), mAdditionalExtdataFolders, mExtdata, mExtdataFolders, index);
 }
 
 std::vector<std::u16string> Title::saves(void)
@@ -322,26 +336,28 @@ std::vector<std::u16string> Title::extdata(void)
 
 void Title::refreshDirectories(void)
 {
+    Trace::Span span("refreshDirectories");
     mSaves.clear();
+    mSaveFolders.clear();
+    mAdditionalSaveFolders.clear();
     mExtdata.clear();
-    mFullSavePaths.clear();
-    mFullExtdataPaths.clear();
+    mExtdataFolders.clear();
+    mAdditionalExtdataFolders.clear();
 
     if (accessibleSave()) {
         // standard save backups
-        Directory savelist(Archive::sdmc(), mSavePath);
+        Directory savelist(Archive::sdmc(), savePath());
         if (savelist.good()) {
             for (size_t i = 0, sz = savelist.size(); i < sz; i++) {
-                if (savelist.folder(i)) {
+                if (savelist.folder(i) || Bundle::hasExtension(StringUtils::UTF16toUTF8(savelist.entry(i)))) {
                     mSaves.push_back(savelist.entry(i));
-                    mFullSavePaths.push_back(mSavePath + StringUtils::UTF8toUTF16("/") + savelist.entry(i));
                 }
             }
 
             std::sort(mSaves.rbegin(), mSaves.rend());
-            std::sort(mFullSavePaths.rbegin(), mFullSavePaths.rend());
+            mSaveFolders.assign(mSaves.size(), 0);
             mSaves.insert(mSaves.begin(), StringUtils::UTF8toUTF16("New..."));
-            mFullSavePaths.insert(mFullSavePaths.begin(), StringUtils::UTF8toUTF16("New..."));
+            mSaveFolders.insert(mSaveFolders.begin(), NEW_BACKUP);
         }
         else {
             Logging::error("Couldn't retrieve the save directory list for the title {}", shortDescription());
@@ -360,11 +376,12 @@ void Title::refreshDirectories(void)
                         Directory list(Archive::sdmc(), *it);
                         if (list.good()) {
                             Logging::debug("Additional save folder is good: {}", StringUtils::UTF16toUTF8(*it));
+                            mAdditionalSaveFolders.push_back(*it);
                             for (size_t i = 0, sz = list.size(); i < sz; i++) {
-                                if (list.folder(i)) {
+                                if (list.folder(i) || Bundle::hasExtension(StringUtils::UTF16toUTF8(list.entry(i)))) {
                                     Logging::debug("Found save folder: {}", StringUtils::UTF16toUTF8(list.entry(i)));
                                     mSaves.push_back(list.entry(i));
-                                    mFullSavePaths.push_back(*it + StringUtils::UTF8toUTF16("/") + list.entry(i));
+                                    mSaveFolders.push_back(mAdditionalSaveFolders.size());
                                 }
                             }
                         }
@@ -389,19 +406,18 @@ void Title::refreshDirectories(void)
 
     if (accessibleExtdata()) {
         // extdata backups
-        Directory extlist(Archive::sdmc(), mExtdataPath);
+        Directory extlist(Archive::sdmc(), extdataPath());
         if (extlist.good()) {
             for (size_t i = 0, sz = extlist.size(); i < sz; i++) {
-                if (extlist.folder(i)) {
+                if (extlist.folder(i) || Bundle::hasExtension(StringUtils::UTF16toUTF8(extlist.entry(i)))) {
                     mExtdata.push_back(extlist.entry(i));
-                    mFullExtdataPaths.push_back(mExtdataPath + StringUtils::UTF8toUTF16("/") + extlist.entry(i));
                 }
             }
 
             std::sort(mExtdata.begin(), mExtdata.end());
-            std::sort(mFullExtdataPaths.begin(), mFullExtdataPaths.end());
+            mExtdataFolders.assign(mExtdata.size(), 0);
             mExtdata.insert(mExtdata.begin(), StringUtils::UTF8toUTF16("New..."));
-            mFullExtdataPaths.insert(mFullExtdataPaths.begin(), StringUtils::UTF8toUTF16("New..."));
+            mExtdataFolders.insert(mExtdataFolders.begin(), NEW_BACKUP);
         }
         else {
             Logging::error("Couldn't retrieve the extdata directory list for the title {}", shortDescription());
@@ -420,11 +436,12 @@ void Title::refreshDirectories(void)
                         Directory list(Archive::sdmc(), *it);
                         if (list.good()) {
                             Logging::debug("Additional extdata folder is good: {}", StringUtils::UTF16toUTF8(*it));
+                            mAdditionalExtdataFolders.push_back(*it);
                             for (size_t i = 0, sz = list.size(); i < sz; i++) {
-                                if (list.folder(i)) {
+                                if (list.folder(i) || Bundle::hasExtension(StringUtils::UTF16toUTF8(list.entry(i)))) {
                                     Logging::debug("Found extdata folder: {}", StringUtils::UTF16toUTF8(list.entry(i)));
                                     mExtdata.push_back(list.entry(i));
-                                    mFullExtdataPaths.push_back(*it + StringUtils::UTF8toUTF16("/") + list.entry(i));
+                                    mExtdataFolders.push_back(mAdditionalExtdataFolders.size());
                                 }
                             }
                         }
@@ -515,7 +532,18 @@ CardType Title::SPICardType(void)
 
 C2D_Image Title::icon(void)
 {
-    return mIcon;
+    // 3DS icons are decoded when drawn, only DS cartridges and placeholders carry their own image
+    return mIcon.tex ? mIcon : IconCache::get(mId, mMedia);
+}
+
+const u16* Title::iconData(void)
+{
+    return mIconData.get();
+}
+
+void Title::releaseIconData(void)
+{
+    mIconData.reset();
 }
 
 void Title::setIcon(C2D_Image icon)
@@ -25,10 +25,13 @@
  */
 
 #include "util.hpp"
+#include "benchmark.hpp"
+#include "iconcache.hpp"
 #include "loader.hpp"
 #include "server.hpp"
 #include "thread.hpp"
 #include "title.hpp"
+#include "trace.hpp"
 #include <malloc.h>
 
 #define SOC_ALIGN 0x1000
@@ -56,7 +59,10 @@ Result servicesInit(void)
     hidInit();
     ATEXIT(hidExit);
 
-    Threads::init(0, 2);
+    // the New 3DS has the cores to spare for a wider title scan
+    bool isNew3DS = false;
+    APT_CheckNew3DS(&isNew3DS);
+    Threads::init(0, isNew3DS ? 4 : 2);
     ATEXIT(Threads::exit);
 
     gfxInitDefault();
@@ -86,6 +92,8 @@ Result servicesInit(void)
     mkdir("sdmc:/cheats", 777);
 
     Logging::initFileLogging();
+    Trace::init();
+    ATEXIT(Trace::exit);
 
     romfsInit();
     ATEXIT(romfsExit);
@@ -101,6 +109,7 @@ Result servicesInit(void)
 
     Gui::init();
     ATEXIT(Gui::exit);
+    ATEXIT(IconCache::exit);
 
     u32* socketBuffer = (u32*)memalign(SOC_ALIGN, SOC_BUFFERSIZE);
     if (socketBuffer != NULL) {
@@ -108,6 +117,7 @@ Result servicesInit(void)
             ATEXIT(socExit);
             Server::init();
             ATEXIT(Server::exit);
+            Benchmark::init();
         }
         else {
             Logging::warning("socInit failed");
@@ -133,28 +143,6 @@ Result servicesInit(void)
     return 0;
 }
 
-void calculateTitleDBHash(u8* hash)
-{
-    u32 titleCount, nandCount, titlesRead, nandTitlesRead;
-    AM_GetTitleCount(MEDIATYPE_SD, &titleCount);
-    if (Configuration::getInstance().nandSaves()) {
-        AM_GetTitleCount(MEDIATYPE_NAND, &nandCount);
-        std::vector<u64> ordered;
-        ordered.reserve(titleCount + nandCount);
-        AM_GetTitleList(&titlesRead, MEDIATYPE_SD, titleCount, ordered.data());
-        AM_GetTitleList(&nandTitlesRead, MEDIATYPE_NAND, nandCount, ordered.data() + titlesRead * sizeof(u64));
-        sort(ordered.begin(), ordered.end());
-        sha256(hash, (u8*)ordered.data(), (titleCount + nandCount) * sizeof(u64));
-    }
-    else {
-        std::vector<u64> ordered;
-        ordered.reserve(titleCount);
-        AM_GetTitleList(&titlesRead, MEDIATYPE_SD, titleCount, ordered.data());
-        sort(ordered.begin(), ordered.end());
-        sha256(hash, (u8*)ordered.data(), titleCount * sizeof(u64));
-    }
-}
-
 std::u16string StringUtils::UTF8toUTF16(const char* src)
 {
     char16_t tmp[256] = {0};
@@ -56,6 +56,24 @@ void Screen::doDraw() const
 
 #endif
 
+bool Screen::frameDue(bool input)
+{
+    if (input) {
+        invalidate();
+    }
+
+    if (fullRateFrames > 0) {
+        fullRateFrames--;
+        idleFrames = 0;
+        return true;
+    }
+    if (++idleFrames >= IDLE_FRAME_INTERVAL) {
+        idleFrames = 0;
+        return true;
+    }
+    return false;
+}
+
 void Screen::doUpdate(const InputState& input)
 {
     if (currentOverlay) {
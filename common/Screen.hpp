@@ -50,13 +50,32 @@ public:
     // Call currentOverlay->update if it exists, and update if it doesn't
     void doUpdate(const InputState&);
     virtual void update(const InputState&) = 0;
-    void removeOverlay() { currentOverlay.reset(); }
-    void setOverlay(std::shared_ptr<Overlay>& overlay) { currentOverlay = overlay; }
+    void removeOverlay()
+    {
+        currentOverlay.reset();
+        invalidate();
+    }
+    void setOverlay(std::shared_ptr<Overlay>& overlay)
+    {
+        currentOverlay = overlay;
+        invalidate();
+    }
+    // Whether the coming frame has to be drawn, or the last one can stay on screen. Frames are drawn at full rate for a moment after
+    // input or invalidate, and otherwise only every IDLE_FRAME_INTERVAL frames, which is enough for pulsing outlines and job progress
+    bool frameDue(bool input);
+    void invalidate(void) { fullRateFrames = FULL_RATE_FRAMES; }
 
 protected:
     // No point in restricting this to only being editable during update, especially since it's drawn afterwards. Allows setting it before the first
     // draw loop is done
     mutable std::shared_ptr<Overlay> currentOverlay;
+
+private:
+    // update runs after draw, so what input changes is only drawn in the frame after it
+    static constexpr int FULL_RATE_FRAMES    = 2;
+    static constexpr int IDLE_FRAME_INTERVAL = 3;
+    int fullRateFrames                       = FULL_RATE_FRAMES;
+    int idleFrames                           = 0;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,265 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "bundle.hpp"
+#include "lz4.hpp"
+#include "xxhash.hpp"
+#include <cstring>
+
+namespace {
+    constexpr char MAGIC[4]       = {'C', 'K', 'B', 'N'};
+    constexpr uint32_t VERSION    = 1;
+    constexpr size_t IO_SIZE      = 0x40000;
+    constexpr uint32_t STORED_BIT = 0x80000000;
+    // far above the index of any real save, but small enough that a damaged header can't exhaust the 3DS heap
+    constexpr uint32_t MAX_INDEX_SIZE = 0x400000;
+    // a directory flag, a path length and a size, with an empty path
+    constexpr uint32_t MIN_ENTRY_SIZE = 11;
+
+    // all integers are little endian regardless of the console
+    void append16(std::vector<uint8_t>& out, uint16_t v)
+    {
+        out.push_back(v & 0xFF);
+        out.push_back(v >> 8);
+    }
+
+    void append32(std::vector<uint8_t>& out, uint32_t v)
+    {
+        for (int i = 0; i < 4; i++) {
+            out.push_back((v >> (8 * i)) & 0xFF);
+        }
+    }
+
+    void append64(std::vector<uint8_t>& out, uint64_t v)
+    {
+        for (int i = 0; i < 8; i++) {
+            out.push_back((v >> (8 * i)) & 0xFF);
+        }
+    }
+
+    uint64_t parse(const uint8_t* p, int bytes)
+    {
+        uint64_t v = 0;
+        for (int i = bytes - 1; i >= 0; i--) {
+            v = (v << 8) | p[i];
+        }
+        return v;
+    }
+}
+
+bool Bundle::hasExtension(const std::string& name)
+{
+    const size_t len = strlen(EXTENSION);
+    return name.length() > len && name.compare(name.length() - len, len, EXTENSION) == 0;
+}
+
+Bundle::Writer::Writer(Sink sink) : mSink(sink)
+{
+    mBuffer.reserve(IO_SIZE);
+    mBlock.resize(BLOCK_SIZE);
+    mCompressed.resize(LZ4::compressBound(BLOCK_SIZE));
+    mTable.resize(LZ4::HASH_TABLE_SIZE);
+}
+
+bool Bundle::Writer::put(const void* data, size_t size)
+{
+    // small writes are gathered, since every file needs at least a block header and a hash
+    if (mBuffer.size() + size > IO_SIZE) {
+        if (!finish()) {
+            return false;
+        }
+        if (size > IO_SIZE) {
+            return mSink(data, size);
+        }
+    }
+    mBuffer.insert(mBuffer.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+    return true;
+}
+
+bool Bundle::Writer::finish(void)
+{
+    bool ok = mBuffer.empty() || mSink(mBuffer.data(), mBuffer.size());
+    mBuffer.clear();
+    return ok;
+}
+
+bool Bundle::Writer::writeIndex(const std::vector<Entry>& entries)
+{
+    std::vector<uint8_t> index;
+    for (const auto& entry : entries) {
+        index.push_back(entry.directory ? 1 : 0);
+        append16(index, entry.path.length());
+        index.insert(index.end(), entry.path.begin(), entry.path.end());
+        append64(index, entry.directory ? 0 : entry.size);
+    }
+    // the reader refuses larger indexes, better to fail now than to write a bundle that can't be restored
+    if (index.size() > MAX_INDEX_SIZE) {
+        return false;
+    }
+
+    std::vector<uint8_t> header(MAGIC, MAGIC + sizeof(MAGIC));
+    append32(header, VERSION);
+    append32(header, entries.size());
+    append32(header, index.size());
+    return put(header.data(), header.size()) && put(index.data(), index.size());
+}
+
+bool Bundle::Writer::writeFile(const Source& source, uint64_t size, const std::function<void(size_t)>& onBlock)
+{
+    XXH64 hash;
+    std::vector<uint8_t> header;
+    while (size > 0) {
+        size_t want = size > BLOCK_SIZE ? BLOCK_SIZE : size;
+        size_t got  = 0;
+        while (got < want) {
+            size_t rd = source(mBlock.data() + got, want - got);
+            if (rd == 0) {
+                return false;
+            }
+            got += rd;
+        }
+        hash.update(mBlock.data(), want);
+
+        // blocks that don't shrink are stored as they are
+        size_t compressed = LZ4::compress(mBlock.data(), want, mCompressed.data(), mCompressed.size(), mTable.data());
+        bool stored       = compressed == 0 || compressed >= want;
+        header.clear();
+        append32(header, stored ? (want | STORED_BIT) : compressed);
+        if (!put(header.data(), header.size()) || !put(stored ? mBlock.data() : mCompressed.data(), stored ? want : compressed)) {
+            return false;
+        }
+
+        size -= want;
+        if (onBlock) {
+            onBlock(want);
+        }
+    }
+
+    header.clear();
+    append64(header, hash.digest());
+    return put(header.data(), header.size());
+}
+
+Bundle::Reader::Reader(Source source) : mSource(source), mPos(0), mLen(0)
+{
+    mBuffer.resize(IO_SIZE);
+    mBlock.resize(BLOCK_SIZE);
+    mCompressed.resize(LZ4::compressBound(BLOCK_SIZE));
+}
+
+bool Bundle::Reader::get(void* data, size_t size)
+{
+    uint8_t* out = (uint8_t*)data;
+    while (size > 0) {
+        if (mPos == mLen) {
+            mPos = 0;
+            mLen = mSource(mBuffer.data(), mBuffer.size());
+            if (mLen == 0) {
+                return false;
+            }
+        }
+        size_t n = mLen - mPos < size ? mLen - mPos : size;
+        memcpy(out, mBuffer.data() + mPos, n);
+        mPos += n;
+        out += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool Bundle::Reader::readIndex(std::vector<Entry>& entries)
+{
+    uint8_t header[16];
+    if (!get(header, sizeof(header)) || memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || parse(header + 4, 4) != VERSION) {
+        return false;
+    }
+
+    // both come straight from the file, so they are checked before anything is allocated for them
+    uint32_t count  = parse(header + 8, 4);
+    uint32_t length = parse(header + 12, 4);
+    if (length > MAX_INDEX_SIZE || count > length / MIN_ENTRY_SIZE) {
+        return false;
+    }
+
+    std::vector<uint8_t> index(length);
+    if (!get(index.data(), index.size())) {
+        return false;
+    }
+
+    entries.clear();
+    size_t pos = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (index.size() - pos < 3) {
+            return false;
+        }
+        bool directory = index[pos] == 1;
+        size_t length  = parse(&index[pos + 1], 2);
+        pos += 3;
+        if (index.size() - pos < length + 8) {
+            return false;
+        }
+        std::string path((const char*)&index[pos], length);
+        pos += length;
+        entries.push_back({path, parse(&index[pos], 8), directory});
+        pos += 8;
+    }
+
+    return pos == index.size();
+}
+
+bool Bundle::Reader::readFile(const Sink& sink, uint64_t size, const std::function<void(size_t)>& onBlock)
+{
+    XXH64 hash;
+    uint8_t header[8];
+    while (size > 0) {
+        size_t want = size > BLOCK_SIZE ? BLOCK_SIZE : size;
+        if (!get(header, 4)) {
+            return false;
+        }
+
+        uint32_t block = parse(header, 4);
+        if (block & STORED_BIT) {
+            if ((block & ~STORED_BIT) != want || !get(mBlock.data(), want)) {
+                return false;
+            }
+        }
+        else if (block > mCompressed.size() || !get(mCompressed.data(), block) || !LZ4::decompress(mCompressed.data(), block, mBlock.data(), want)) {
+            return false;
+        }
+
+        hash.update(mBlock.data(), want);
+        if (!sink(mBlock.data(), want)) {
+            return false;
+        }
+
+        size -= want;
+        if (onBlock) {
+            onBlock(want);
+        }
+    }
+
+    return get(header, 8) && parse(header, 8) == hash.digest();
+}
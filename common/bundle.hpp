@@ -0,0 +1,98 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef BUNDLE_HPP
+#define BUNDLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Single-file backup format. A bundle starts with an index of the whole tree (paths and sizes, parents
+// before their children), followed by the body of every file in index order. Bodies are cut into
+// LZ4-compressed blocks of at most BLOCK_SIZE bytes and end with the XXH64 of their contents, so both
+// writing and reading are one sequential pass and a restore can stream straight out of the file.
+//
+// Storage is left to the caller through Sink and Source, which keeps this shared by both consoles.
+namespace Bundle {
+    inline constexpr const char* EXTENSION = ".bundle";
+    inline constexpr size_t BLOCK_SIZE     = 0x10000;
+
+    struct Entry {
+        std::string path; // UTF-8, relative to the backup root
+        uint64_t size;
+        bool directory;
+    };
+
+    // Sink writes all of the given bytes or fails. Source returns how many bytes it read, 0 at the end.
+    using Sink   = std::function<bool(const void*, size_t)>;
+    using Source = std::function<size_t(void*, size_t)>;
+
+    bool hasExtension(const std::string& name);
+
+    class Writer {
+    public:
+        Writer(Sink sink);
+        ~Writer() = default;
+
+        bool writeIndex(const std::vector<Entry>& entries);
+        // Appends the body of the next file, pulling exactly size bytes from source.
+        bool writeFile(const Source& source, uint64_t size, const std::function<void(size_t)>& onBlock = nullptr);
+        bool finish(void);
+
+    private:
+        bool put(const void* data, size_t size);
+
+        Sink mSink;
+        std::vector<uint8_t> mBuffer;
+        std::vector<uint8_t> mBlock;
+        std::vector<uint8_t> mCompressed;
+        std::vector<uint32_t> mTable;
+    };
+
+    class Reader {
+    public:
+        Reader(Source source);
+        ~Reader() = default;
+
+        bool readIndex(std::vector<Entry>& entries);
+        // Decodes the body of the next file into sink, checking its length and hash.
+        bool readFile(const Sink& sink, uint64_t size, const std::function<void(size_t)>& onBlock = nullptr);
+
+    private:
+        bool get(void* data, size_t size);
+
+        Source mSource;
+        std::vector<uint8_t> mBuffer;
+        size_t mPos, mLen;
+        std::vector<uint8_t> mBlock;
+        std::vector<uint8_t> mCompressed;
+    };
+}
+
+#endif
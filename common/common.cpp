@@ -55,6 +55,16 @@ std::string DateTime::logDateTime(void)
         timeStruct.tm_hour, timeStruct.tm_min, timeStruct.tm_sec);
 }
 
+std::string DateTime::etaStr(unsigned long long done, unsigned long long total, unsigned long long elapsedMs)
+{
+    // the first second is dominated by mounting and small files, don't extrapolate from it
+    if (done == 0 || done >= total || elapsedMs < 1000) {
+        return "";
+    }
+    unsigned long long seconds = (total - done) * elapsedMs / done / 1000;
+    return StringUtils::format("%llu:%02llu left", seconds / 60, seconds % 60);
+}
+
 std::string StringUtils::UTF16toUTF8(const std::u16string& src)
 {
     static std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> convert;
@@ -47,6 +47,8 @@ namespace DateTime {
     std::string timeStr(void);
     std::string dateTimeStr(void);
     std::string logDateTime(void);
+    // Remaining time of a transfer, extrapolated from its average rate so far. Empty until there is enough data.
+    std::string etaStr(unsigned long long done, unsigned long long total, unsigned long long elapsedMs);
 }
 
 namespace StringUtils {
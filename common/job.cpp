@@ -0,0 +1,132 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "job.hpp"
+
+#if defined(__3DS__)
+#include "thread.hpp"
+#include <3ds.h>
+#endif
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+
+namespace {
+    std::atomic<bool> busy = false;
+    std::function<Job::Outcome(void)> pending;
+    std::mutex outcomeMutex;
+    std::optional<Job::Outcome> outcome;
+
+#if defined(__SWITCH__)
+    constexpr size_t JOB_STACK = 0x20000;
+    Thread worker;
+    bool workerCreated = false;
+#endif
+
+    void run(void*)
+    {
+        // the work used to run inside main's try/catch, an exception here would otherwise terminate the worker and leave busy set
+        Job::Outcome result;
+        try {
+            result = pending();
+        }
+        catch (const std::exception& e) {
+            result = Job::Outcome(false, -1, e.what());
+        }
+        catch (...) {
+            result = Job::Outcome(false, -1, "Unknown error during the operation.");
+        }
+        pending = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(outcomeMutex);
+            outcome = std::move(result);
+        }
+        busy = false;
+    }
+}
+
+bool Job::start(std::function<Outcome(void)> task)
+{
+    bool expected = false;
+    if (!busy.compare_exchange_strong(expected, true)) {
+        return false;
+    }
+
+    pending = std::move(task);
+
+#if defined(__3DS__)
+    Threads::executeTask(run, nullptr);
+#elif defined(__SWITCH__)
+    if (workerCreated) {
+        threadWaitForExit(&worker);
+        threadClose(&worker);
+        workerCreated = false;
+    }
+
+    if (R_SUCCEEDED(threadCreate(&worker, run, nullptr, nullptr, JOB_STACK, 0x2C, -2))) {
+        workerCreated = true;
+        threadStart(&worker);
+    }
+    else {
+        // better a frozen UI than a lost backup
+        run(nullptr);
+    }
+#endif
+
+    return true;
+}
+
+bool Job::running(void)
+{
+    return busy;
+}
+
+std::optional<Job::Outcome> Job::collect(void)
+{
+    if (busy) {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(outcomeMutex);
+    std::optional<Outcome> ret = std::move(outcome);
+    outcome.reset();
+    return ret;
+}
+
+void Job::wait(void)
+{
+#if defined(__3DS__)
+    while (busy) {
+        svcSleepThread(10000000);
+    }
+#elif defined(__SWITCH__)
+    if (workerCreated) {
+        threadWaitForExit(&worker);
+        threadClose(&worker);
+        workerCreated = false;
+    }
+#endif
+}
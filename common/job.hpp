@@ -0,0 +1,55 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef JOB_HPP
+#define JOB_HPP
+
+#if defined(__3DS__)
+#include <3ds/types.h>
+#elif defined(__SWITCH__)
+#include <switch.h>
+#endif
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <tuple>
+
+// A single long-running file operation (backup, restore) executed away from the UI thread.
+// The UI keeps drawing at its own frame rate and picks up the outcome once the job is done.
+namespace Job {
+    using Outcome = std::tuple<bool, Result, std::string>;
+
+    // Returns false without running the task if another job is still in flight.
+    bool start(std::function<Outcome(void)> task);
+    bool running(void);
+    // Hands out the outcome of the last finished job exactly once.
+    std::optional<Outcome> collect(void);
+    // Blocks until the current job, if any, is done.
+    void wait(void);
+}
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "lz4.hpp"
+#include <cstring>
+
+namespace {
+    constexpr size_t MIN_MATCH     = 4;
+    constexpr size_t MAX_OFFSET    = 0xFFFF;
+    constexpr size_t LAST_LITERALS = 5;
+    constexpr size_t MF_LIMIT      = 12;
+
+    inline uint32_t read32(const uint8_t* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint32_t hash(uint32_t sequence)
+    {
+        return (sequence * 2654435761U) >> (32 - LZ4::HASH_BITS);
+    }
+
+    // writes the 255-continued remainder of a length that didn't fit in its token nibble
+    inline uint8_t* writeLength(uint8_t* op, size_t length)
+    {
+        for (; length >= 255; length -= 255) {
+            *op++ = 255;
+        }
+        *op++ = (uint8_t)length;
+        return op;
+    }
+}
+
+size_t LZ4::compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity, uint32_t* table)
+{
+    memset(table, 0, HASH_TABLE_SIZE * sizeof(*table));
+    const uint8_t* ip     = src;
+    const uint8_t* anchor = src;
+    const uint8_t* end    = src + size;
+    uint8_t* op           = dst;
+    uint8_t* oend         = dst + capacity;
+
+    if (size >= MF_LIMIT + 1) {
+        const uint8_t* mflimit    = end - MF_LIMIT;
+        const uint8_t* matchlimit = end - LAST_LITERALS;
+        size_t misses             = 0;
+
+        while (ip < mflimit) {
+            uint32_t sequence  = read32(ip);
+            uint32_t h         = hash(sequence);
+            const uint8_t* ref = src + table[h];
+            table[h]           = (uint32_t)(ip - src);
+            if (ref >= ip || (size_t)(ip - ref) > MAX_OFFSET || read32(ref) != sequence) {
+                // skip ahead faster the longer the data doesn't compress
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            size_t match = MIN_MATCH;
+            while (ip + match < matchlimit && ip[match] == ref[match]) {
+                match++;
+            }
+
+            size_t literals = ip - anchor;
+            if ((size_t)(oend - op) < literals + literals / 255 + match / 255 + 8) {
+                return 0;
+            }
+
+            uint8_t* token = op++;
+            *token         = (uint8_t)((literals >= 15 ? 15 : literals) << 4);
+            if (literals >= 15) {
+                op = writeLength(op, literals - 15);
+            }
+            memcpy(op, anchor, literals);
+            op += literals;
+
+            uint16_t offset = (uint16_t)(ip - ref);
+            *op++           = offset & 0xFF;
+            *op++           = offset >> 8;
+
+            size_t extra = match - MIN_MATCH;
+            *token |= (uint8_t)(extra >= 15 ? 15 : extra);
+            if (extra >= 15) {
+                op = writeLength(op, extra - 15);
+            }
+
+            ip += match;
+            anchor = ip;
+        }
+    }
+
+    size_t literals = end - anchor;
+    if ((size_t)(oend - op) < literals + literals / 255 + 2) {
+        return 0;
+    }
+    *op++ = (uint8_t)((literals >= 15 ? 15 : literals) << 4);
+    if (literals >= 15) {
+        op = writeLength(op, literals - 15);
+    }
+    memcpy(op, anchor, literals);
+    op += literals;
+
+    return op - dst;
+}
+
+bool LZ4::decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size)
+{
+    const uint8_t* ip   = src;
+    const uint8_t* iend = src + srcSize;
+    uint8_t* op         = dst;
+    uint8_t* oend       = dst + size;
+
+    while (ip < iend) {
+        uint8_t token   = *ip++;
+        size_t literals = token >> 4;
+        if (literals == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return false;
+                }
+                b = *ip++;
+                literals += b;
+            } while (b == 255);
+        }
+        if (literals > (size_t)(iend - ip) || literals > (size_t)(oend - op)) {
+            return false;
+        }
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        // the last sequence has no match
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return false;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return false;
+        }
+
+        size_t match = token & 15;
+        if (match == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return false;
+                }
+                b = *ip++;
+                match += b;
+            } while (b == 255);
+        }
+        match += MIN_MATCH;
+        if (match > (size_t)(oend - op)) {
+            return false;
+        }
+
+        // byte by byte, matches may overlap their own output
+        const uint8_t* ref = op - offset;
+        for (size_t i = 0; i < match; i++) {
+            op[i] = ref[i];
+        }
+        op += match;
+    }
+
+    return op == oend;
+}
@@ -0,0 +1,54 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef LZ4_HPP
+#define LZ4_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Minimal LZ4 block codec (raw blocks, no frame format). Output is compatible with the reference
+// implementation; compression is the single-pass greedy variant, which is what matters on the
+// consoles' slow CPUs.
+namespace LZ4 {
+    inline constexpr int HASH_BITS = 12;
+    // entries of the match table compress works with, owned by the caller so it stays off the (small) stack of job threads
+    inline constexpr size_t HASH_TABLE_SIZE = size_t(1) << HASH_BITS;
+
+    // worst-case compressed size of size bytes
+    constexpr size_t compressBound(size_t size)
+    {
+        return size + size / 255 + 16;
+    }
+
+    // Returns the compressed size, or 0 if the output would not fit into capacity. table holds HASH_TABLE_SIZE entries, its
+    // contents don't matter and are overwritten.
+    size_t compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity, uint32_t* table);
+    // Returns false unless src decodes to exactly size bytes without reading or writing out of bounds.
+    bool decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size);
+}
+
+#endif
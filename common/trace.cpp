@@ -0,0 +1,124 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "trace.hpp"
+#include "logging.hpp"
+
+#if defined(__3DS__)
+#include "server.hpp"
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <mutex>
+#include <vector>
+
+namespace {
+    // 2048 spans are enough for a full startup with a few hundred titles, older ones are overwritten after that
+    constexpr size_t TRACE_CAPACITY = 2048;
+
+    struct Event {
+        const char* name;
+        uint32_t thread;
+        int64_t start;
+        int64_t duration;
+    };
+
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    std::mutex traceMutex;
+    std::array<Event, TRACE_CAPACITY> events;
+    size_t recorded = 0;
+
+    std::atomic<uint32_t> nextThread  = 0;
+    thread_local uint32_t threadIndex = nextThread++;
+
+#if defined(__3DS__)
+    constexpr const char* TRACE_PATH = "sdmc:/3ds/Checkpoint/logs/trace.json";
+#elif defined(__SWITCH__)
+    constexpr const char* TRACE_PATH = "/switch/Checkpoint/logs/trace.json";
+#else
+    constexpr const char* TRACE_PATH = "trace.json";
+#endif
+}
+
+void Trace::record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    const Event event = {name, threadIndex, std::chrono::duration_cast<std::chrono::microseconds>(start - epoch).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()};
+
+    std::lock_guard<std::mutex> lock(traceMutex);
+    events[recorded % TRACE_CAPACITY] = event;
+    recorded++;
+}
+
+std::string Trace::json(void)
+{
+    // copied out oldest first so the lock is not held while formatting, on the heap since the server thread has a small stack
+    std::vector<Event> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        const size_t count = std::min(recorded, TRACE_CAPACITY);
+        const size_t first = recorded > TRACE_CAPACITY ? recorded % TRACE_CAPACITY : 0;
+        snapshot.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            snapshot.push_back(events[(first + i) % TRACE_CAPACITY]);
+        }
+    }
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Checkpoint\"}}";
+    for (const Event& event : snapshot) {
+        out += std::format(",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{},\"dur\":{}}}", event.name, event.thread, event.start,
+            event.duration);
+    }
+    out += "]}\n";
+    return out;
+}
+
+void Trace::init(void)
+{
+#if defined(SERVER_HPP)
+    Server::registerHandler("/trace",
+        [](const std::string&, const std::string&) -> Server::HttpResponse { return {200, "application/json", json()}; });
+#endif
+}
+
+void Trace::exit(void)
+{
+    const std::string data = json();
+    FILE* file             = fopen(TRACE_PATH, "w");
+    if (file == nullptr) {
+        Logging::warning("Failed to write the trace to {}.", TRACE_PATH);
+        return;
+    }
+    fwrite(data.data(), 1, data.size(), file);
+    fclose(file);
+}
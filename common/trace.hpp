@@ -0,0 +1,59 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>
+#include <string>
+
+namespace Trace {
+    // Registers the /trace endpoint on the HTTP server, where there is one.
+    void init(void);
+    // Writes the recorded spans to the log directory.
+    void exit(void);
+
+    // Records a finished span. name is kept as a pointer, so it has to be a string literal.
+    void record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+    // The recorded spans as Chrome trace-event JSON, to be opened in chrome://tracing or ui.perfetto.dev.
+    std::string json(void);
+
+    // Records the lifetime of the enclosing scope. Spans nest by time on each thread, so a span opened inside another one shows up below it.
+    class Span {
+    public:
+        explicit Span(const char* name) : mName(name), mStart(std::chrono::steady_clock::now()) {}
+        ~Span(void) { record(mName, mStart, std::chrono::steady_clock::now()); }
+
+        Span(const Span&)            = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* mName;
+        std::chrono::steady_clock::time_point mStart;
+    };
+}
+
+#endif
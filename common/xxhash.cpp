@@ -0,0 +1,164 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "xxhash.hpp"
+#include <cstring>
+
+namespace {
+    constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+    inline uint64_t rotl(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t read64(const uint8_t* p)
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint32_t read32(const uint8_t* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t round(uint64_t acc, uint64_t input)
+    {
+        acc += input * PRIME2;
+        acc = rotl(acc, 31);
+        return acc * PRIME1;
+    }
+
+    inline uint64_t merge(uint64_t acc, uint64_t val)
+    {
+        acc ^= round(0, val);
+        return acc * PRIME1 + PRIME4;
+    }
+}
+
+XXH64::XXH64(uint64_t seed)
+{
+    mSeed     = seed;
+    mAcc[0]   = seed + PRIME1 + PRIME2;
+    mAcc[1]   = seed + PRIME2;
+    mAcc[2]   = seed;
+    mAcc[3]   = seed - PRIME1;
+    mBuffered = 0;
+    mTotal    = 0;
+}
+
+void XXH64::update(const void* data, size_t size)
+{
+    const uint8_t* p   = (const uint8_t*)data;
+    const uint8_t* end = p + size;
+    mTotal += size;
+
+    if (mBuffered + size < 32) {
+        memcpy(mBuffer + mBuffered, p, size);
+        mBuffered += size;
+        return;
+    }
+
+    if (mBuffered > 0) {
+        size_t fill = 32 - mBuffered;
+        memcpy(mBuffer + mBuffered, p, fill);
+        mAcc[0] = round(mAcc[0], read64(mBuffer));
+        mAcc[1] = round(mAcc[1], read64(mBuffer + 8));
+        mAcc[2] = round(mAcc[2], read64(mBuffer + 16));
+        mAcc[3] = round(mAcc[3], read64(mBuffer + 24));
+        p += fill;
+        mBuffered = 0;
+    }
+
+    while (p + 32 <= end) {
+        mAcc[0] = round(mAcc[0], read64(p));
+        mAcc[1] = round(mAcc[1], read64(p + 8));
+        mAcc[2] = round(mAcc[2], read64(p + 16));
+        mAcc[3] = round(mAcc[3], read64(p + 24));
+        p += 32;
+    }
+
+    if (p < end) {
+        mBuffered = end - p;
+        memcpy(mBuffer, p, mBuffered);
+    }
+}
+
+uint64_t XXH64::digest(void) const
+{
+    uint64_t h;
+    if (mTotal >= 32) {
+        h = rotl(mAcc[0], 1) + rotl(mAcc[1], 7) + rotl(mAcc[2], 12) + rotl(mAcc[3], 18);
+        h = merge(h, mAcc[0]);
+        h = merge(h, mAcc[1]);
+        h = merge(h, mAcc[2]);
+        h = merge(h, mAcc[3]);
+    }
+    else {
+        h = mSeed + PRIME5;
+    }
+    h += mTotal;
+
+    const uint8_t* p   = mBuffer;
+    const uint8_t* end = mBuffer + mBuffered;
+    while (p + 8 <= end) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t XXH64::hash(const void* data, size_t size, uint64_t seed)
+{
+    XXH64 state(seed);
+    state.update(data, size);
+    return state.digest();
+}
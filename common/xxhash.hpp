@@ -0,0 +1,53 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef XXHASH_HPP
+#define XXHASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Streaming XXH64, used to tell whether a file changed between two backups without comparing
+// the contents byte by byte. Not a cryptographic hash.
+class XXH64 {
+public:
+    XXH64(uint64_t seed = 0);
+    ~XXH64() = default;
+
+    void update(const void* data, size_t size);
+    uint64_t digest(void) const;
+
+    static uint64_t hash(const void* data, size_t size, uint64_t seed = 0);
+
+private:
+    uint64_t mAcc[4];
+    uint8_t mBuffer[32];
+    size_t mBuffered;
+    uint64_t mTotal;
+    uint64_t mSeed;
+};
+
+#endif
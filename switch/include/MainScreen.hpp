@@ -35,10 +35,12 @@
 #include "clickable.hpp"
 #include "hid.hpp"
 #include "io.hpp"
+#include "job.hpp"
 #include "main.hpp"
 #include "multiselection.hpp"
 #include "pksmbridge.hpp"
 #include "scrollable.hpp"
+#include "title.hpp"
 #include <tuple>
 
 typedef enum { TITLES, CELLS } entryType_t;
@@ -66,6 +68,9 @@ protected:
     void setPKSMBridgeFlag(bool f);
     void updateButtons(void);
     std::string sortMode(void) const;
+    void startBackup(void);
+    void startRestore(void);
+    void refreshSelection(void) const;
 
 private:
     entryType_t type;
@@ -76,6 +81,16 @@ private:
     std::unique_ptr<Scrollable> backupList;
     std::unique_ptr<Clickable> buttonCheats, buttonBackup, buttonRestore;
     char ver[8];
+    // the selected title and everything drawn for it, kept across frames and only rebuilt by refreshSelection when the
+    // selection, the title order or its backups change. Draw runs before update, so it refreshes them itself
+    mutable Title selectedTitle;
+    mutable AccountUid selectedUid;
+    mutable size_t selectedIndex;
+    mutable size_t selectedCell;
+    mutable u32 selectedTitlesGeneration;
+    mutable u32 selectedBackupsGeneration;
+    mutable std::string selectedName, selectedId, selectedAuthor, selectedUser, selectedPlayTime;
+    mutable u32 selectedName_w;
 };
 
 #endif
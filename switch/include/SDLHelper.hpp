@@ -36,6 +36,7 @@
 #include <string>
 #include <switch.h>
 #include <unordered_map>
+#include <vector>
 
 bool SDLH_Init(void);
 void SDLH_Exit(void);
@@ -45,6 +46,9 @@ void SDLH_DrawRect(int x, int y, int w, int h, SDL_Color color);
 void SDLH_DrawText(int size, int x, int y, SDL_Color color, const char* text);
 void SDLH_LoadImage(SDL_Texture** texture, char* path);
 void SDLH_LoadImage(SDL_Texture** texture, u8* buff, size_t size);
+// Decodes an image into w * h tightly packed RGB24 pixels, which SDLH_LoadPixels turns into a texture like SDLH_LoadImage would.
+bool SDLH_DecodeImage(u8* buff, size_t size, std::vector<u8>& pixels, int* w, int* h);
+void SDLH_LoadPixels(SDL_Texture** texture, u8* pixels, int w, int h);
 void SDLH_DrawImage(SDL_Texture* texture, int x, int y);
 void SDLH_DrawImageScale(SDL_Texture* texture, int x, int y, int w, int h);
 void SDLH_DrawIcon(std::string icon, int x, int y);
@@ -0,0 +1,62 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef CHUNKSTORE_HPP
+#define CHUNKSTORE_HPP
+
+#include "io.hpp"
+#include <string>
+#include <switch.h>
+#include <vector>
+
+// Deduplicated backup storage. Files are split into content-defined chunks (FastCDC), every unique
+// chunk is stored once under CHUNKS_PATH keyed by its sha256, and a backup folder only holds a small
+// manifest listing the tree and the chunks each file is rebuilt from. Backups of the same save share
+// nearly all of their chunks, so a repeat backup writes little more than the manifest.
+namespace ChunkStore {
+    inline const std::string CHUNKS_PATH   = "sdmc:/switch/Checkpoint/chunks";
+    inline const std::string MANIFEST_NAME = ".checkpoint-chunks";
+
+    struct Snapshot {
+        io::Manifest manifest;                        // tree the backup restores to
+        std::vector<std::vector<std::string>> chunks; // chunk hashes of each manifest entry
+    };
+
+    bool isChunked(const std::string& folder);
+
+    Result backup(const io::Manifest& manifest, const std::string& srcPath, const std::string& folder);
+    Result load(const std::string& folder, Snapshot& snapshot);
+    Result restore(const Snapshot& snapshot, const std::string& dstPath);
+
+    // Single-file access for callers that need one file of a chunked backup rather than the whole tree.
+    bool readFile(const std::string& folder, const std::string& path, std::vector<u8>& data);
+    Result importFile(const std::string& folder, const std::string& path);
+
+    // Deletes every chunk no manifest under the backup folders refers to anymore.
+    void collectGarbage(void);
+}
+
+#endif
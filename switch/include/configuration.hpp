@@ -27,6 +27,7 @@
 #ifndef CONFIGHANDLER_HPP
 #define CONFIGHANDLER_HPP
 
+#include "copypipeline.hpp"
 #include "io.hpp"
 #include "json.hpp"
 #include "util.hpp"
@@ -51,7 +52,12 @@ public:
     bool favorite(u64 id);
     bool isPKSMBridgeEnabled(void);
     bool isFTPEnabled(void);
+    size_t copyBufferCount(void);
+    size_t copyBufferSize(void);
+    bool chunkedBackups(void);
+    bool bundledBackups(void);
     std::vector<std::string> additionalSaveFolders(u64 id);
+    std::vector<std::string> additionalSaveFolders(void);
     void cleanup(void);
     void pollServer(void);
     void save(void);
@@ -74,6 +80,10 @@ private:
     nlohmann::json mJson;
     bool PKSMBridgeEnabled;
     bool FTPEnabled;
+    size_t mCopyBufferCount;
+    size_t mCopyBufferSize;
+    bool mChunkedBackups;
+    bool mBundledBackups;
     bool mCleanedUp = false;
     std::unordered_set<u64> mFilterIds, mFavoriteIds;
     std::unordered_map<u64, std::vector<std::string>> mAdditionalSaveFolders;
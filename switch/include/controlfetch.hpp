@@ -0,0 +1,79 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef CONTROLFETCH_HPP
+#define CONTROLFETCH_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <switch.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Fetches application control data on a few worker threads, once per application id. Ids are queued while
+// the saves are still being enumerated, so the ns requests overlap with the fs ones. Applications whose
+// installed version matches cachedVersions only have their version looked up.
+class ControlFetch {
+public:
+    static constexpr size_t DEFAULT_WORKERS = 3;
+
+    struct Entry {
+        u32 version;
+        // the control data wasn't fetched, the title cache entry of this version is still good
+        bool cached;
+        std::string name;
+        std::string author;
+        std::vector<u8> icon;
+    };
+
+    ControlFetch(size_t workers, std::unordered_map<u64, u32> cachedVersions);
+    ~ControlFetch();
+
+    // Queues id, unless it was requested before.
+    void request(u64 id);
+    // Helps with the remaining ids and waits for the workers. Entries can only be read after this.
+    void finish(void);
+    // nullptr if the application has no usable control data.
+    Entry* get(u64 id);
+
+private:
+    static void workerThread(void* arg);
+    void work(void);
+
+    const std::unordered_map<u64, u32> mCachedVersions;
+    std::vector<Thread> mThreads;
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    std::deque<u64> mQueue;
+    std::unordered_set<u64> mRequested;
+    std::unordered_map<u64, Entry> mEntries;
+    bool mClosed;
+};
+
+#endif
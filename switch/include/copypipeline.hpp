@@ -0,0 +1,82 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef COPYPIPELINE_HPP
+#define COPYPIPELINE_HPP
+
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <switch.h>
+#include <vector>
+
+// Copies a file through a ring of buffers: a reader thread fills the ring from the source while
+// the calling thread drains it into the destination, so the SD read and the save write overlap.
+class CopyPipeline {
+public:
+    static constexpr size_t DEFAULT_DEPTH       = 4;
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 0x80000;
+
+    CopyPipeline(size_t depth, size_t bufferSize);
+    ~CopyPipeline() = default;
+
+    // Returns false if the destination could not be written completely. onChunk is called on the
+    // calling thread after every chunk that reaches the destination, with the amount written.
+    bool copy(FILE* src, FILE* dst, const std::function<void(size_t)>& onChunk = nullptr);
+
+    size_t depth(void) const { return mSlots.size(); }
+    size_t bufferSize(void) const { return mBufferSize; }
+
+    u64 bytes(void) const { return mBytes; }
+    u64 elapsedMs(void) const { return mElapsedNs / 1000000; }
+    double bytesPerSecond(void) const;
+    void resetStats(void);
+
+private:
+    struct Slot {
+        std::unique_ptr<u8[]> data;
+        size_t size;
+    };
+
+    static void readerThread(void* arg);
+    void produce(void);
+
+    std::vector<Slot> mSlots;
+    size_t mBufferSize;
+
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    FILE* mSrc;
+    size_t mHead, mTail, mFilled;
+    bool mEof, mAbort;
+
+    u64 mBytes;
+    u64 mElapsedNs;
+};
+
+#endif
@@ -34,6 +34,15 @@ namespace FileSystem {
     Result mount(FsFileSystem* fileSystem, u64 titleID, AccountUid userID);
     int mount(FsFileSystem fs);
     void unmount(void);
+
+    // Commit scheduling for the mounted save. Writes accumulate in the save's journal until the next
+    // commit, so instead of committing after every file the writer reserves journal space up front and
+    // a commit only happens when the next write would not fit anymore, plus once in endCommits.
+    void beginCommits(u64 saveId);
+    Result reserveJournal(u64 size);
+    // Commits right away, for changes that never reserved journal space such as wiping the whole save.
+    Result commitJournal(void);
+    Result endCommits(void);
 }
 
 #endif
\ No newline at end of file
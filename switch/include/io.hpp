@@ -29,27 +29,51 @@
 
 #include "KeyboardManager.hpp"
 #include "account.hpp"
+#include "copypipeline.hpp"
 #include "directory.hpp"
 #include "multiselection.hpp"
 #include "title.hpp"
 #include "util.hpp"
 #include <dirent.h>
+#include <memory>
 #include <switch.h>
 #include <sys/stat.h>
 #include <tuple>
 #include <unistd.h>
 #include <utility>
 
-#define BUFFER_SIZE 0x80000
-
 namespace io {
-    std::tuple<bool, Result, std::string> backup(size_t index, AccountUid uid, size_t cellIndex);
+    struct ManifestEntry {
+        std::string path; // relative to the manifest root
+        u64 size;
+        bool directory;
+    };
+
+    // Flat listing of a tree, parents before their children, gathered in a single walk so
+    // progress totals and the copy itself don't need to traverse the tree again.
+    struct Manifest {
+        std::vector<ManifestEntry> entries;
+        size_t files = 0;
+        u64 bytes    = 0;
+    };
+
+    // Resolves the destination folder name for a backup, prompting the user through the system
+    // keyboard when a new folder is being created. Must be called from the UI thread.
+    std::pair<bool, std::string> backupName(AccountUid uid, size_t cellIndex);
+    std::string suggestedBackupName(AccountUid uid);
+    std::tuple<bool, Result, std::string> backup(size_t index, AccountUid uid, size_t cellIndex, const std::string& customPath);
     std::tuple<bool, Result, std::string> restore(size_t index, AccountUid uid, size_t cellIndex, const std::string& nameFromCell);
 
-    size_t countFiles(const std::string& path);
+    Result buildManifest(const std::string& root, Manifest& manifest);
     Result copyDirectory(const std::string& srcPath, const std::string& dstPath);
-    void copyFile(const std::string& srcPath, const std::string& dstPath);
+    Result copyManifest(const Manifest& manifest, const std::string& srcPath, const std::string& dstPath);
+    // Makes dstPath match the manifest of srcPath, writing only the files that differ and deleting the
+    // ones the manifest doesn't list.
+    Result syncManifest(const Manifest& manifest, const std::string& srcPath, const std::string& dstPath);
+    // size is the source file's length as recorded in its manifest entry, used to reserve save journal space
+    Result copyFile(const std::string& srcPath, const std::string& dstPath, u64 size);
     Result createDirectory(const std::string& path);
+    void deleteBackupFolder(const std::string& path);
     Result deleteFolderRecursively(const std::string& path);
     bool directoryExists(const std::string& path);
     bool fileExists(const std::string& path);
@@ -32,7 +32,9 @@
 #include "account.hpp"
 #include "title.hpp"
 #include "util.hpp"
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <switch.h>
 
 typedef enum { SORT_ALPHA, SORT_LAST_PLAYED, SORT_PLAY_TIME, SORT_MODES_COUNT } sort_t;
@@ -49,10 +51,16 @@ inline std::vector<std::string> g_selectedCheatCodes;
 inline u32 g_username_dotsize;
 inline sort_t g_sortMode         = SORT_ALPHA;
 inline const InputState* g_input = nullptr;
+// transfer progress, written by the job thread and read by the UI at its own frame rate
+inline std::atomic<bool> g_isTransferringFile = false;
+inline std::atomic<size_t> g_copyCount        = 0;
+inline std::atomic<size_t> g_copyTotal        = 0;
+inline std::atomic<u64> g_copyBytes           = 0;
+inline std::atomic<u64> g_copyBytesTotal      = 0;
+inline std::atomic<u64> g_copyStartTime       = 0; // ms
+// guards g_currentFile and g_transferMode
+inline std::mutex g_transferMutex;
 inline std::string g_currentFile = "";
-inline bool g_isTransferringFile = false;
-inline size_t g_copyCount        = 0;
-inline size_t g_copyTotal        = 0;
 inline std::string g_transferMode;
 
 #endif
\ No newline at end of file
@@ -33,15 +33,39 @@
 #include "filesystem.hpp"
 #include "io.hpp"
 #include <algorithm>
+#include <memory>
+#include <mutex>
 #include <stdlib.h>
 #include <string>
 #include <switch.h>
 #include <unordered_map>
 #include <vector>
 
+// Backups of an application, listed the first time they are needed or by the background scan after loadTitles.
+// Backup names are kept once, along with the folder they live in: 0 for the title path, i + 1 for the i-th additional one
+struct BackupList {
+    std::mutex mutex;
+    bool listed = false;
+    // bumped on every listing, so the UI only rebuilds its backup list when this changes
+    u32 generation = 0;
+    std::vector<std::string> saves;
+    std::vector<u16> folders;
+    std::vector<std::string> additionalFolders;
+};
+
+// Everything about a title that doesn't depend on the user, shared by the titles of every user with a save for it
+struct TitleInfo {
+    u64 id;
+    std::string name;
+    std::string author;
+    std::string displayName;
+    std::string path;
+    std::shared_ptr<BackupList> backups;
+};
+
 class Title {
 public:
-    void init(u8 saveDataType, u64 titleid, AccountUid userID, const std::string& name, const std::string& author);
+    void init(u8 saveDataType, u64 titleid, AccountUid userID, std::shared_ptr<const TitleInfo> info);
     ~Title() = default;
 
     std::string author(void);
@@ -60,6 +84,7 @@ public:
     u64 saveId();
     void saveId(u64 id);
     std::vector<std::string> saves(void);
+    u32 backupsGeneration(void);
     u8 saveDataType(void);
     AccountUid userId(void);
     std::string userName(void);
@@ -69,26 +94,22 @@ private:
     u64 mSaveId;
     AccountUid mUserId;
     std::string mUserName;
-    std::string mName;
-    std::string mSafeName;
-    std::string mAuthor;
-    std::string mPath;
-    std::vector<std::string> mSaves;
-    std::vector<std::string> mFullSavePaths;
+    std::shared_ptr<const TitleInfo> mInfo;
     u8 mSaveDataType;
-    std::string mDisplayName;
     u64 mPlayTimeNanoseconds;
     u32 mLastPlayedTimestamp;
 };
 
 void getTitle(Title& dst, AccountUid uid, size_t i);
 size_t getTitleCount(AccountUid uid);
+u32 getTitlesGeneration(void);
 void loadTitles(void);
 void sortTitles(void);
 void rotateSortMode(void);
 void refreshDirectories(u64 id);
 bool favorite(AccountUid uid, int i);
 void freeIcons(void);
+void stopBackupScan(void);
 SDL_Texture* smallIcon(AccountUid uid, size_t i);
 std::unordered_map<std::string, std::string> getCompleteTitleList(void);
 
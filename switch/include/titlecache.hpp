@@ -0,0 +1,58 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef TITLECACHE_HPP
+#define TITLECACHE_HPP
+
+#include <string>
+#include <switch.h>
+#include <unordered_map>
+#include <vector>
+
+// Name, author and decoded icon of every application with a save, keyed by application id and version, so that a warm
+// launch needs neither the control data from ns nor the JPEG decoder.
+namespace TitleCache {
+    struct Entry {
+        u32 version;
+        std::string name;
+        std::string author;
+        u16 iconWidth;
+        u16 iconHeight;
+        // where the RGB24 pixels of the icon start in the cache file, 0 while they are only held in pixels
+        u64 iconOffset;
+        std::vector<u8> pixels;
+    };
+
+    // Reads the entry table. Leaves entries empty if there is no cache or it can't be trusted.
+    void load(std::unordered_map<u64, Entry>& entries);
+    // Replaces the cache with entries, copying the icons that are only in the old file. Afterwards every entry refers to
+    // the new file and its pixels are released.
+    bool save(std::unordered_map<u64, Entry>& entries);
+    // Reads width * height RGB24 pixels at offset out of the cache file.
+    bool readIcon(u64 offset, u16 width, u16 height, std::vector<u8>& pixels);
+}
+
+#endif
@@ -34,6 +34,12 @@ MainScreen::MainScreen(const InputState& input) : hid(rowlen * collen, collen, i
     wantInstructions = false;
     selectionTimer   = 0;
     sprintf(ver, "v%d.%d.%d", VERSION_MAJOR, VERSION_MINOR, VERSION_MICRO);
+    selectedUid               = {};
+    selectedIndex             = 0;
+    selectedCell              = 0;
+    selectedTitlesGeneration  = 0;
+    selectedBackupsGeneration = 0;
+    selectedName_w            = 0;
     backupList    = std::make_unique<Scrollable>(536, 316, 416, 408, rows);
     buttonBackup  = std::make_unique<Clickable>(956, 316, 224, 80, COLOR_BLACK_DARKER, COLOR_GREY_LIGHT, "Backup \ue004", true);
     buttonRestore = std::make_unique<Clickable>(956, 400, 224, 80, COLOR_BLACK_DARKER, COLOR_GREY_LIGHT, "Restore \ue005", true);
@@ -118,36 +124,21 @@ void MainScreen::draw() const
         20, 16 * 3 + checkpoint_w + 8 + ver_w, (TOPBAR_h - checkpoint_h) / 2 + checkpoint_h - ver_h + 2, COLOR_GREY_LIGHT, "\ue046 Instructions");
 
     if (getTitleCount(g_currentUId) > 0) {
-        Title title;
-        getTitle(title, g_currentUId, hid.fullIndex());
+        refreshSelection();
 
-        backupList->flush();
-        std::vector<std::string> dirs = title.saves();
-
-        for (size_t i = 0; i < dirs.size(); i++) {
-            backupList->push_back(COLOR_BLACK_DARKER, COLOR_WHITE, dirs.at(i), i == backupList->index());
-        }
-
-        if (title.icon() != NULL) {
+        SDL_Texture* icon = selectedTitle.icon();
+        if (icon != NULL) {
             drawOutline(1020, 52, 256, 256, 4, COLOR_BLACK_DARK);
-            SDLH_DrawImage(title.icon(), 1020, 52);
+            SDLH_DrawImage(icon, 1020, 52);
         }
 
-        u32 h = 29, offset = 56, i = 0, title_w;
-        auto gameName = title.displayName();
-        SDLH_GetTextDimensions(26, gameName.c_str(), &title_w, NULL);
-
-        if (title_w >= 720) {
-            gameName = gameName.substr(0, 40) + "...";
-            SDLH_GetTextDimensions(26, gameName.c_str(), &title_w, NULL);
-        }
-
-        SDLH_DrawText(26, 1280 - 8 - title_w, (TOPBAR_h - checkpoint_h) / 2 + 4, COLOR_WHITE, gameName.c_str());
-        SDLH_DrawText(23, 538, offset + h * (i++), COLOR_GREY_LIGHT, StringUtils::format("Title ID: %016llX", title.id()).c_str());
-        SDLH_DrawText(23, 538, offset + h * (i++), COLOR_GREY_LIGHT, ("Author: " + title.author()).c_str());
-        SDLH_DrawText(23, 538, offset + h * (i++), COLOR_GREY_LIGHT, ("User: " + title.userName()).c_str());
-        if (!title.playTime().empty()) {
-            SDLH_DrawText(23, 538, offset + h * i, COLOR_GREY_LIGHT, ("Play Time: " + title.playTime()).c_str());
+        u32 h = 29, offset = 56, i = 0;
+        SDLH_DrawText(26, 1280 - 8 - selectedName_w, (TOPBAR_h - checkpoint_h) / 2 + 4, COLOR_WHITE, selectedName.c_str());
+        SDLH_DrawText(23, 538, offset + h * (i++), COLOR_GREY_LIGHT, selectedId.c_str());
+        SDLH_DrawText(23, 538, offset + h * (i++), COLOR_GREY_LIGHT, selectedAuthor.c_str());
+        SDLH_DrawText(23, 538, offset + h * (i++), COLOR_GREY_LIGHT, selectedUser.c_str());
+        if (!selectedPlayTime.empty()) {
+            SDLH_DrawText(23, 538, offset + h * i, COLOR_GREY_LIGHT, selectedPlayTime.c_str());
         }
 
         backupList->draw(g_backupScrollEnabled);
@@ -188,15 +179,23 @@ void MainScreen::draw() const
         SDLH_DrawRect(mx, my, mw, mh, COLOR_BLACK_DARKERR);
         drawOutline(mx, my, mw, mh, 3, COLOR_PURPLE_LIGHT);
 
+        std::string titleStr, currentFile;
+        {
+            std::lock_guard<std::mutex> lock(g_transferMutex);
+            titleStr    = (g_transferMode.empty() ? "Copying files" : g_transferMode) + " in progress...";
+            currentFile = g_currentFile;
+        }
+        const size_t copyCount = g_copyCount, copyTotal = g_copyTotal;
+        const u64 copyBytes = g_copyBytes, copyBytesTotal = g_copyBytesTotal;
+
         // Title
-        std::string titleStr = (g_transferMode.empty() ? "Copying files" : g_transferMode) + " in progress...";
         u32 title_w, title_h;
         SDLH_GetTextDimensions(26, titleStr.c_str(), &title_w, &title_h);
         SDLH_DrawText(26, mx + (mw - (int)title_w) / 2, my + 14, COLOR_WHITE, titleStr.c_str());
 
         // Current filename
         u32 fname_w, fname_h;
-        std::string fname = trimToFit(g_currentFile, mw - 40, 22);
+        std::string fname = trimToFit(currentFile, mw - 40, 22);
         SDLH_GetTextDimensions(22, fname.c_str(), &fname_w, &fname_h);
         SDLH_DrawText(22, mx + (mw - (int)fname_w) / 2, my + 14 + (int)title_h + 8, COLOR_GREY_LIGHT, fname.c_str());
 
@@ -204,7 +203,7 @@ void MainScreen::draw() const
         const int barX = mx + 20, barY = my + 110, barW = mw - 40, barH = 18;
         SDLH_DrawRect(barX, barY, barW, barH, COLOR_BLACK_MEDIUM);
 
-        float progress = (g_copyTotal > 0) ? (float)g_copyCount / (float)g_copyTotal : 0.0f;
+        float progress = copyBytesTotal > 0 ? (float)copyBytes / (float)copyBytesTotal : copyTotal > 0 ? (float)copyCount / (float)copyTotal : 0.0f;
         if (progress > 1.0f)
             progress = 1.0f;
         int fillW = (int)(barW * progress);
@@ -215,7 +214,7 @@ void MainScreen::draw() const
 
         // Count (left) and percentage (right) below bar
         char countStr[24];
-        snprintf(countStr, sizeof(countStr), "%zu / %zu", g_copyCount, g_copyTotal);
+        snprintf(countStr, sizeof(countStr), "%zu / %zu", copyCount, copyTotal);
         char pctStr[8];
         snprintf(pctStr, sizeof(pctStr), "%d%%%%", (int)(progress * 100));
 
@@ -223,15 +222,120 @@ void MainScreen::draw() const
         SDLH_GetTextDimensions(20, pctStr, &pct_w, &pct_h);
         SDLH_DrawText(20, barX, barY + barH + 6, COLOR_GREY_LIGHT, countStr);
         SDLH_DrawText(20, barX + barW - (int)pct_w, barY + barH + 6, COLOR_WHITE, pctStr);
+
+        std::string eta = DateTime::etaStr(copyBytes, copyBytesTotal, armTicksToNs(armGetSystemTick()) / 1000000 - g_copyStartTime);
+        if (!eta.empty()) {
+            u32 eta_w, eta_h;
+            SDLH_GetTextDimensions(20, eta.c_str(), &eta_w, &eta_h);
+            SDLH_DrawText(20, barX + (barW - (int)eta_w) / 2, barY + barH + 6, COLOR_GREY_LIGHT, eta.c_str());
+        }
     }
 }
 
+void MainScreen::refreshSelection(void) const
+{
+    const size_t index     = hid.fullIndex();
+    const u32 generation   = getTitlesGeneration();
+    const bool titleChange = selectedUid != g_currentUId || selectedIndex != index || selectedTitlesGeneration != generation;
+    if (titleChange) {
+        selectedTitle = {};
+        getTitle(selectedTitle, g_currentUId, index);
+        selectedUid              = g_currentUId;
+        selectedIndex            = index;
+        selectedTitlesGeneration = generation;
+
+        selectedName = selectedTitle.displayName();
+        SDLH_GetTextDimensions(26, selectedName.c_str(), &selectedName_w, NULL);
+        if (selectedName_w >= 720) {
+            selectedName = selectedName.substr(0, 40) + "...";
+            SDLH_GetTextDimensions(26, selectedName.c_str(), &selectedName_w, NULL);
+        }
+        selectedId       = StringUtils::format("Title ID: %016llX", selectedTitle.id());
+        selectedAuthor   = "Author: " + selectedTitle.author();
+        selectedUser     = "User: " + selectedTitle.userName();
+        selectedPlayTime = selectedTitle.playTime();
+        if (!selectedPlayTime.empty()) {
+            selectedPlayTime = "Play Time: " + selectedPlayTime;
+        }
+    }
+
+    // the cells are only made again when another title is selected or a job relisted the backups of this one
+    const u32 backups = selectedTitle.backupsGeneration();
+    const size_t cell = backupList->index();
+    if (titleChange || selectedBackupsGeneration != backups) {
+        backupList->flush();
+        std::vector<std::string> dirs = selectedTitle.saves();
+        for (size_t i = 0; i < dirs.size(); i++) {
+            backupList->push_back(COLOR_BLACK_DARKER, COLOR_WHITE, dirs.at(i), i == cell);
+        }
+        selectedBackupsGeneration = backups;
+    }
+    else if (selectedCell != cell) {
+        if (selectedCell < backupList->size()) {
+            backupList->selectRow(selectedCell, false);
+        }
+        if (cell < backupList->size()) {
+            backupList->selectRow(cell, true);
+        }
+    }
+    selectedCell = cell;
+}
+
 void MainScreen::update(const InputState& input)
 {
+    // input stays locked while a backup or restore runs in the background
+    if (Job::running()) {
+        return;
+    }
+
+    if (auto outcome = Job::collect()) {
+        if (std::get<0>(*outcome)) {
+            currentOverlay = std::make_shared<InfoOverlay>(*this, std::get<2>(*outcome));
+        }
+        else {
+            currentOverlay = std::make_shared<ErrorOverlay>(*this, std::get<1>(*outcome), std::get<2>(*outcome));
+        }
+        // the job finished without any input, its result has to show up right away
+        invalidate();
+        return;
+    }
+
     updateSelector(input);
     handleEvents(input);
 }
 
+void MainScreen::startBackup(void)
+{
+    const size_t titleIndex = this->index(TITLES);
+    const size_t cellIndex  = this->index(CELLS);
+    const AccountUid uid    = g_currentUId;
+
+    // the keyboard has to be shown from the UI thread, before the job starts
+    std::pair<bool, std::string> name = io::backupName(uid, cellIndex);
+    if (!name.first) {
+        currentOverlay = std::make_shared<ErrorOverlay>(*this, 0, "Operation aborted by the user.");
+        return;
+    }
+
+    Job::start([titleIndex, uid, cellIndex, customPath = name.second]() {
+        auto result = io::backup(titleIndex, uid, cellIndex, customPath);
+        if (std::get<0>(result)) {
+            blinkLed(4);
+        }
+        return result;
+    });
+}
+
+void MainScreen::startRestore(void)
+{
+    const size_t titleIndex = this->index(TITLES);
+    const size_t cellIndex  = this->index(CELLS);
+    const AccountUid uid    = g_currentUId;
+    const std::string name  = nameFromCell(cellIndex);
+
+    Job::start([titleIndex, uid, cellIndex, name]() { return io::restore(titleIndex, uid, cellIndex, name); });
+}
+
 void MainScreen::updateSelector(const InputState& input)
 {
     if (!g_backupScrollEnabled) {
@@ -281,10 +385,9 @@ void MainScreen::handleEvents(const InputState& input)
     }
     // handle PKSM bridge
     if (Configuration::getInstance().isPKSMBridgeEnabled()) {
-        Title title;
-        getTitle(title, g_currentUId, this->index(TITLES));
+        refreshSelection();
         if (!getPKSMBridgeFlag()) {
-            if ((kheld & HidNpadButton_L) && (kheld & HidNpadButton_R) && isPKSMBridgeTitle(title.id())) {
+            if ((kheld & HidNpadButton_L) && (kheld & HidNpadButton_R) && isPKSMBridgeTitle(selectedTitle.id())) {
                 setPKSMBridgeFlag(true);
                 updateButtons();
             }
@@ -322,13 +425,7 @@ void MainScreen::handleEvents(const InputState& input)
             // If the "New..." entry is selected...
             if (0 == this->index(CELLS)) {
                 if (!getPKSMBridgeFlag()) {
-                    auto result = io::backup(this->index(TITLES), g_currentUId, this->index(CELLS));
-                    if (std::get<0>(result)) {
-                        currentOverlay = std::make_shared<InfoOverlay>(*this, std::get<2>(result));
-                    }
-                    else {
-                        currentOverlay = std::make_shared<ErrorOverlay>(*this, std::get<1>(result), std::get<2>(result));
-                    }
+                    startBackup();
                 }
             }
             else {
@@ -345,13 +442,8 @@ void MainScreen::handleEvents(const InputState& input)
                     currentOverlay = std::make_shared<YesNoOverlay>(
                         *this, "Restore selected save?",
                         [this]() {
-                            auto result = io::restore(this->index(TITLES), g_currentUId, this->index(CELLS), nameFromCell(this->index(CELLS)));
-                            if (std::get<0>(result)) {
-                                currentOverlay = std::make_shared<InfoOverlay>(*this, std::get<2>(result));
-                            }
-                            else {
-                                currentOverlay = std::make_shared<ErrorOverlay>(*this, std::get<1>(result), std::get<2>(result));
-                            }
+                            this->removeOverlay();
+                            startRestore();
                         },
                         [this]() { this->removeOverlay(); });
                 }
@@ -388,7 +480,7 @@ void MainScreen::handleEvents(const InputState& input)
                         Title title;
                         getTitle(title, g_currentUId, this->index(TITLES));
                         std::string path = title.fullPath(index);
-                        io::deleteFolderRecursively((path + "/").c_str());
+                        io::deleteBackupFolder(path);
                         refreshDirectories(title.id());
                         this->index(CELLS, index - 1);
                         this->removeOverlay();
@@ -437,20 +529,17 @@ void MainScreen::handleEvents(const InputState& input)
         if (MS::multipleSelectionEnabled()) {
             resetIndex(CELLS);
             std::vector<size_t> list = MS::selectedEntries();
-            for (size_t i = 0, sz = list.size(); i < sz; i++) {
-                // check if multiple selection is enabled and don't ask for confirmation if that's the case
-                auto result = io::backup(list.at(i), g_currentUId, this->index(CELLS));
-                if (std::get<0>(result)) {
-                    currentOverlay = std::make_shared<InfoOverlay>(*this, std::get<2>(result));
-                }
-                else {
-                    currentOverlay = std::make_shared<ErrorOverlay>(*this, std::get<1>(result), std::get<2>(result));
+            const AccountUid uid     = g_currentUId;
+            Job::start([list, uid]() {
+                // multiple selection doesn't ask for confirmation nor for a folder name
+                for (size_t i = 0, sz = list.size(); i < sz; i++) {
+                    io::backup(list.at(i), uid, 0, io::suggestedBackupName(uid));
                 }
-            }
+                blinkLed(4);
+                return Job::Outcome(true, 0, "Progress correctly saved to disk.");
+            });
             MS::clearSelectedEntries();
             updateButtons();
-            blinkLed(4);
-            currentOverlay = std::make_shared<InfoOverlay>(*this, "Progress correctly saved to disk.");
         }
         else if (g_backupScrollEnabled) {
             if (getPKSMBridgeFlag()) {
@@ -473,13 +562,8 @@ void MainScreen::handleEvents(const InputState& input)
                 currentOverlay = std::make_shared<YesNoOverlay>(
                     *this, "Backup selected save?",
                     [this]() {
-                        auto result = io::backup(this->index(TITLES), g_currentUId, this->index(CELLS));
-                        if (std::get<0>(result)) {
-                            currentOverlay = std::make_shared<InfoOverlay>(*this, std::get<2>(result));
-                        }
-                        else {
-                            currentOverlay = std::make_shared<ErrorOverlay>(*this, std::get<1>(result), std::get<2>(result));
-                        }
+                        this->removeOverlay();
+                        startBackup();
                     },
                     [this]() { this->removeOverlay(); });
             }
@@ -508,13 +592,8 @@ void MainScreen::handleEvents(const InputState& input)
                     currentOverlay = std::make_shared<YesNoOverlay>(
                         *this, "Restore selected save?",
                         [this]() {
-                            auto result = io::restore(this->index(TITLES), g_currentUId, this->index(CELLS), nameFromCell(this->index(CELLS)));
-                            if (std::get<0>(result)) {
-                                currentOverlay = std::make_shared<InfoOverlay>(*this, std::get<2>(result));
-                            }
-                            else {
-                                currentOverlay = std::make_shared<ErrorOverlay>(*this, std::get<1>(result), std::get<2>(result));
-                            }
+                            this->removeOverlay();
+                            startRestore();
                         },
                         [this]() { this->removeOverlay(); });
                 }
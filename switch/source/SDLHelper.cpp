@@ -164,6 +164,41 @@ void SDLH_LoadImage(SDL_Texture** texture, u8* buff, size_t size)
     SDL_FreeSurface(loaded_surface);
 }
 
+bool SDLH_DecodeImage(u8* buff, size_t size, std::vector<u8>& pixels, int* w, int* h)
+{
+    SDL_Surface* loaded_surface = IMG_Load_RW(SDL_RWFromMem(buff, size), 1);
+    if (loaded_surface == NULL) {
+        return false;
+    }
+    SDL_Surface* rgb = SDL_ConvertSurfaceFormat(loaded_surface, SDL_PIXELFORMAT_RGB24, 0);
+    SDL_FreeSurface(loaded_surface);
+    if (rgb == NULL) {
+        return false;
+    }
+
+    // rows are padded to the surface pitch, the pixels are kept without it
+    *w = rgb->w;
+    *h = rgb->h;
+    pixels.resize(rgb->w * rgb->h * 3);
+    for (int y = 0; y < rgb->h; y++) {
+        memcpy(pixels.data() + y * rgb->w * 3, (u8*)rgb->pixels + y * rgb->pitch, rgb->w * 3);
+    }
+    SDL_FreeSurface(rgb);
+    return true;
+}
+
+void SDLH_LoadPixels(SDL_Texture** texture, u8* pixels, int w, int h)
+{
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(pixels, w, h, 24, w * 3, SDL_PIXELFORMAT_RGB24);
+    if (surface) {
+        Uint32 colorkey = SDL_MapRGB(surface->format, 0, 0, 0);
+        SDL_SetColorKey(surface, SDL_TRUE, colorkey);
+        *texture = SDL_CreateTextureFromSurface(s_renderer, surface);
+    }
+
+    SDL_FreeSurface(surface);
+}
+
 void SDLH_DrawImage(SDL_Texture* texture, int x, int y)
 {
     SDL_Rect position;
@@ -0,0 +1,521 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "chunkstore.hpp"
+#include "filesystem.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+extern "C" {
+#include "sha256.h"
+}
+
+namespace {
+    constexpr int MANIFEST_VERSION = 1;
+
+    // Sizes are large compared to textbook FastCDC: every chunk is a file on a FAT32/exFAT card, and
+    // chunks much smaller than a cluster would give back in slack what deduplication saves.
+    constexpr size_t MIN_CHUNK = 0x4000;
+    constexpr size_t AVG_CHUNK = 0x10000;
+    constexpr size_t MAX_CHUNK = 0x40000;
+
+    // normalized chunking: cutting is harder before the average size and easier after it
+    constexpr u64 MASK_SMALL = 0x3FFFFULL << 46;
+    constexpr u64 MASK_LARGE = 0x3FFFULL << 50;
+
+    // Gear table from a fixed splitmix64 sequence. It decides every cut point, so changing it would
+    // stop new backups from sharing chunks with existing ones.
+    constexpr std::array<u64, 256> makeGear(void)
+    {
+        std::array<u64, 256> gear{};
+        u64 state = 0x436865636B706F69ULL;
+        for (auto& value : gear) {
+            u64 z = (state += 0x9E3779B97F4A7C15ULL);
+            z     = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z     = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            value = z ^ (z >> 31);
+        }
+        return gear;
+    }
+
+    constexpr std::array<u64, 256> GEAR = makeGear();
+
+    // length of the chunk starting at data, size being everything available from there
+    size_t cut(const u8* data, size_t size)
+    {
+        if (size <= MIN_CHUNK) {
+            return size;
+        }
+
+        const size_t normal = std::min(size, AVG_CHUNK);
+        const size_t limit  = std::min(size, MAX_CHUNK);
+        u64 hash            = 0;
+        size_t i            = MIN_CHUNK;
+        for (; i < normal; i++) {
+            hash = (hash << 1) + GEAR[data[i]];
+            if (!(hash & MASK_SMALL)) {
+                return i + 1;
+            }
+        }
+        for (; i < limit; i++) {
+            hash = (hash << 1) + GEAR[data[i]];
+            if (!(hash & MASK_LARGE)) {
+                return i + 1;
+            }
+        }
+        return limit;
+    }
+
+    // Streams a file through the chunker. The window is refilled whenever less than a maximum chunk is
+    // left, so every cut sees as much data as it could use.
+    bool chunkFile(FILE* src, const std::function<bool(const u8*, size_t)>& onChunk)
+    {
+        std::vector<u8> window(MAX_CHUNK * 4);
+        size_t pos = 0, len = 0;
+        bool eof   = false;
+        while (true) {
+            if (!eof && len - pos < MAX_CHUNK) {
+                memmove(window.data(), window.data() + pos, len - pos);
+                len -= pos;
+                pos = 0;
+                len += fread(window.data() + len, 1, window.size() - len, src);
+                if (ferror(src)) {
+                    return false;
+                }
+                eof = len < window.size();
+            }
+            if (pos == len) {
+                return true;
+            }
+
+            size_t size = cut(window.data() + pos, len - pos);
+            if (!onChunk(window.data() + pos, size)) {
+                return false;
+            }
+            pos += size;
+        }
+    }
+
+    std::string hashChunk(const u8* data, size_t size)
+    {
+        SHA256_CTX ctx;
+        u8 digest[SHA256_BLOCK_SIZE];
+        sha256_init(&ctx);
+        sha256_update(&ctx, data, size);
+        sha256_final(&ctx, digest);
+
+        std::string hex;
+        for (size_t i = 0; i < SHA256_BLOCK_SIZE; i++) {
+            hex += StringUtils::format("%02x", digest[i]);
+        }
+        return hex;
+    }
+
+    std::string chunkPath(const std::string& hash)
+    {
+        return ChunkStore::CHUNKS_PATH + "/" + hash.substr(0, 2) + "/" + hash;
+    }
+
+    bool storeChunk(const std::string& hash, const u8* data, size_t size)
+    {
+        std::string path = chunkPath(hash);
+        if (io::fileExists(path)) {
+            return true;
+        }
+
+        // written under a temporary name so an interrupted backup never leaves a truncated chunk behind
+        io::createDirectory(ChunkStore::CHUNKS_PATH + "/" + hash.substr(0, 2));
+        std::string tmp = path + ".tmp";
+        FILE* out       = fopen(tmp.c_str(), "wb");
+        if (out == NULL) {
+            return false;
+        }
+        bool ok = fwrite(data, 1, size, out) == size;
+        ok      = fclose(out) == 0 && ok;
+        ok      = ok && rename(tmp.c_str(), path.c_str()) == 0;
+        if (!ok) {
+            std::remove(tmp.c_str());
+        }
+        return ok;
+    }
+
+    bool readChunk(const std::string& hash, std::vector<u8>& data)
+    {
+        FILE* in = fopen(chunkPath(hash).c_str(), "rb");
+        if (in == NULL) {
+            Logging::error("Chunk {} is missing.", hash);
+            return false;
+        }
+        fseek(in, 0, SEEK_END);
+        data.resize(ftell(in));
+        rewind(in);
+        bool ok = fread(data.data(), 1, data.size(), in) == data.size();
+        fclose(in);
+
+        if (!ok || hashChunk(data.data(), data.size()) != hash) {
+            Logging::error("Chunk {} is unreadable or corrupted.", hash);
+            return false;
+        }
+        return true;
+    }
+
+    // chunks a whole file into the store, collecting the hashes it is rebuilt from
+    bool storeFile(FILE* src, nlohmann::json& chunks)
+    {
+        chunks = nlohmann::json::array();
+        return chunkFile(src, [&chunks](const u8* data, size_t size) {
+            std::string hash = hashChunk(data, size);
+            if (!storeChunk(hash, data, size)) {
+                Logging::error("Failed to store chunk {} with errno {}.", hash, errno);
+                return false;
+            }
+            chunks.push_back(hash);
+            g_copyBytes += size;
+            return true;
+        });
+    }
+
+    // Whether an entry has the types every reader of the manifest relies on. A manifest edited by hand or damaged on the card may not,
+    // and nlohmann::json throws on a mismatch
+    bool validEntry(const nlohmann::json& entry)
+    {
+        if (!entry.is_object() || !entry.contains("path") || !entry["path"].is_string()) {
+            return false;
+        }
+        if (entry.contains("directory")) {
+            if (!entry["directory"].is_boolean()) {
+                return false;
+            }
+            if (entry["directory"].get<bool>()) {
+                return true;
+            }
+        }
+        if (entry.contains("size") && !entry["size"].is_number_unsigned()) {
+            return false;
+        }
+        if (entry.contains("chunks")) {
+            if (!entry["chunks"].is_array()) {
+                return false;
+            }
+            for (const auto& hash : entry["chunks"]) {
+                if (!hash.is_string()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool readManifest(const std::string& folder, nlohmann::json& json)
+    {
+        FILE* in = fopen((folder + "/" + ChunkStore::MANIFEST_NAME).c_str(), "rb");
+        if (in == NULL) {
+            return false;
+        }
+        json = nlohmann::json::parse(in, nullptr, false);
+        fclose(in);
+
+        if (!json.is_object() || !json["version"].is_number_unsigned() || json["version"] != MANIFEST_VERSION || !json["entries"].is_array() ||
+            !std::all_of(json["entries"].begin(), json["entries"].end(), validEntry)) {
+            Logging::error("Chunk manifest in {} is unreadable.", folder);
+            return false;
+        }
+        return true;
+    }
+
+    bool writeManifest(const std::string& folder, const nlohmann::json& json)
+    {
+        std::string data = json.dump();
+        FILE* out        = fopen((folder + "/" + ChunkStore::MANIFEST_NAME).c_str(), "wb");
+        if (out == NULL) {
+            return false;
+        }
+        bool ok = fwrite(data.data(), 1, data.size(), out) == data.size();
+        return fclose(out) == 0 && ok;
+    }
+
+    void setCurrentFile(const std::string& path)
+    {
+        size_t slashpos = path.rfind("/");
+        std::lock_guard<std::mutex> lock(g_transferMutex);
+        g_currentFile = path.substr(slashpos + 1);
+    }
+}
+
+bool ChunkStore::isChunked(const std::string& folder)
+{
+    return io::fileExists(folder + "/" + MANIFEST_NAME);
+}
+
+Result ChunkStore::backup(const io::Manifest& manifest, const std::string& srcPath, const std::string& folder)
+{
+    nlohmann::json json;
+    json["version"] = MANIFEST_VERSION;
+    json["entries"] = nlohmann::json::array();
+
+    for (const auto& entry : manifest.entries) {
+        if (entry.directory) {
+            json["entries"].push_back({{"path", entry.path}, {"directory", true}});
+            continue;
+        }
+
+        std::string path = srcPath + entry.path;
+        FILE* src        = fopen(path.c_str(), "rb");
+        if (src == NULL) {
+            Logging::error("Failed to open source file {} during backup with errno {}. Skipping...", path, errno);
+            continue;
+        }
+
+        setCurrentFile(path);
+        nlohmann::json chunks;
+        bool ok = storeFile(src, chunks);
+        fclose(src);
+        if (!ok) {
+            return -1;
+        }
+        json["entries"].push_back({{"path", entry.path}, {"size", entry.size}, {"chunks", chunks}});
+        g_copyCount++;
+    }
+
+    if (!writeManifest(folder, json)) {
+        Logging::error("Failed to write the chunk manifest in {} with errno {}.", folder, errno);
+        return -1;
+    }
+    return 0;
+}
+
+Result ChunkStore::load(const std::string& folder, ChunkStore::Snapshot& snapshot)
+{
+    nlohmann::json json;
+    if (!readManifest(folder, json)) {
+        return -1;
+    }
+
+    snapshot = Snapshot();
+    // every chunk is looked up before the caller wipes the save, so a missing or truncated one fails the restore while the save is
+    // still intact. Chunks shared by several files are only looked up once
+    std::unordered_map<std::string, u64> chunkSizes;
+    // readManifest checked the type of every field, the defaults below only cover missing ones
+    for (const auto& entry : json["entries"]) {
+        std::string path = entry["path"].get<std::string>();
+        if (entry.value("directory", false)) {
+            snapshot.manifest.entries.push_back({path, 0, true});
+            snapshot.chunks.emplace_back();
+            continue;
+        }
+
+        u64 size                        = entry.value("size", 0ULL);
+        std::vector<std::string> chunks = entry.value("chunks", std::vector<std::string>());
+        u64 stored                      = 0;
+        for (const auto& hash : chunks) {
+            auto known = chunkSizes.find(hash);
+            if (known == chunkSizes.end()) {
+                struct stat st;
+                if (stat(chunkPath(hash).c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+                    Logging::error("Chunk {} of {} in {} is missing.", hash, path, folder);
+                    return -1;
+                }
+                known = chunkSizes.emplace(hash, st.st_size).first;
+            }
+            stored += known->second;
+        }
+        if (stored != size) {
+            Logging::error("Chunks of {} in {} hold {} bytes instead of {}.", path, folder, stored, size);
+            return -1;
+        }
+
+        snapshot.manifest.entries.push_back({path, size, false});
+        snapshot.chunks.push_back(std::move(chunks));
+        snapshot.manifest.files++;
+        snapshot.manifest.bytes += size;
+    }
+
+    return 0;
+}
+
+Result ChunkStore::restore(const ChunkStore::Snapshot& snapshot, const std::string& dstPath)
+{
+    std::vector<u8> data;
+    for (size_t i = 0; i < snapshot.manifest.entries.size(); i++) {
+        const auto& entry = snapshot.manifest.entries[i];
+        std::string path  = dstPath + entry.path;
+        if (entry.directory) {
+            io::createDirectory(path);
+            continue;
+        }
+
+        if (dstPath.rfind("save:/", 0) == 0) {
+            Result res = FileSystem::reserveJournal(entry.size);
+            if (R_FAILED(res)) {
+                Logging::error("Failed to commit save before writing {} with result 0x{:08X}.", path, res);
+                return res;
+            }
+        }
+        FILE* dst = fopen(path.c_str(), "wb");
+        if (dst == NULL) {
+            Logging::error("Failed to open destination file {} during restore with errno {}.", path, errno);
+            return -1;
+        }
+
+        setCurrentFile(path);
+        bool ok = true;
+        for (const auto& hash : snapshot.chunks[i]) {
+            ok = readChunk(hash, data) && fwrite(data.data(), 1, data.size(), dst) == data.size();
+            if (!ok) {
+                break;
+            }
+            g_copyBytes += data.size();
+        }
+        ok = fclose(dst) == 0 && ok;
+        if (!ok) {
+            return -1;
+        }
+        g_copyCount++;
+    }
+
+    return 0;
+}
+
+bool ChunkStore::readFile(const std::string& folder, const std::string& path, std::vector<u8>& data)
+{
+    Snapshot snapshot;
+    if (R_FAILED(load(folder, snapshot))) {
+        return false;
+    }
+
+    for (size_t i = 0; i < snapshot.manifest.entries.size(); i++) {
+        if (snapshot.manifest.entries[i].directory || snapshot.manifest.entries[i].path != path) {
+            continue;
+        }
+
+        std::vector<u8> chunk;
+        data.clear();
+        for (const auto& hash : snapshot.chunks[i]) {
+            if (!readChunk(hash, chunk)) {
+                return false;
+            }
+            data.insert(data.end(), chunk.begin(), chunk.end());
+        }
+        return true;
+    }
+
+    return false;
+}
+
+Result ChunkStore::importFile(const std::string& folder, const std::string& path)
+{
+    nlohmann::json json;
+    if (!readManifest(folder, json)) {
+        return -1;
+    }
+
+    std::string rawPath = folder + "/" + path;
+    FILE* src           = fopen(rawPath.c_str(), "rb");
+    if (src == NULL) {
+        return -1;
+    }
+    struct stat st;
+    u64 size = stat(rawPath.c_str(), &st) == 0 ? st.st_size : 0;
+    nlohmann::json chunks;
+    bool ok = storeFile(src, chunks);
+    fclose(src);
+    if (!ok) {
+        return -1;
+    }
+
+    auto& entries = json["entries"];
+    auto existing = std::find_if(entries.begin(), entries.end(), [&path](const nlohmann::json& entry) { return entry.value("path", "") == path; });
+    nlohmann::json entry = {{"path", path}, {"size", size}, {"chunks", chunks}};
+    if (existing != entries.end()) {
+        *existing = entry;
+    }
+    else {
+        entries.push_back(entry);
+    }
+
+    if (!writeManifest(folder, json)) {
+        return -1;
+    }
+    std::remove(rawPath.c_str());
+    return 0;
+}
+
+void ChunkStore::collectGarbage(void)
+{
+    // every folder that may hold backups: the default tree, one level per title, plus the user's extra folders
+    std::vector<std::string> roots;
+    Directory titles("sdmc:/switch/Checkpoint/saves");
+    for (size_t i = 0, sz = titles.good() ? titles.size() : 0; i < sz; i++) {
+        if (titles.folder(i)) {
+            roots.push_back("sdmc:/switch/Checkpoint/saves/" + titles.entry(i));
+        }
+    }
+    for (const auto& folder : Configuration::getInstance().additionalSaveFolders()) {
+        roots.push_back(folder);
+    }
+
+    std::unordered_set<std::string> live;
+    for (const auto& root : roots) {
+        Directory backups(root);
+        for (size_t i = 0, sz = backups.good() ? backups.size() : 0; i < sz; i++) {
+            std::string folder = root + "/" + backups.entry(i);
+            if (!backups.folder(i) || !isChunked(folder)) {
+                continue;
+            }
+
+            // a manifest we can't read may still reference anything, so leave the store alone
+            nlohmann::json json;
+            if (!readManifest(folder, json)) {
+                Logging::warning("Skipping chunk cleanup, {} could not be read.", folder);
+                return;
+            }
+            for (const auto& entry : json["entries"]) {
+                for (const auto& hash : entry.value("chunks", std::vector<std::string>())) {
+                    live.insert(hash);
+                }
+            }
+        }
+    }
+
+    size_t removed = 0;
+    Directory prefixes(CHUNKS_PATH);
+    for (size_t i = 0, sz = prefixes.good() ? prefixes.size() : 0; i < sz; i++) {
+        std::string prefix = CHUNKS_PATH + "/" + prefixes.entry(i);
+        Directory chunks(prefix);
+        for (size_t j = 0, csz = chunks.good() ? chunks.size() : 0; j < csz; j++) {
+            if (!chunks.folder(j) && live.find(chunks.entry(j)) == live.end()) {
+                std::remove((prefix + "/" + chunks.entry(j)).c_str());
+                removed++;
+            }
+        }
+    }
+
+    Logging::info("Removed {} unreferenced chunks, {} still in use.", removed, live.size());
+}
@@ -25,6 +25,7 @@
  */
 
 #include "configuration.hpp"
+#include <algorithm>
 
 static struct mg_mgr mgr;
 static struct mg_connection* nc;
@@ -115,6 +116,19 @@ Configuration::Configuration(void)
             mJson["ftp-enabled"] = false;
             updateJson           = true;
         }
+        if (!(mJson.contains("copy-buffers") && mJson["copy-buffers"].is_number_unsigned())) {
+            mJson["copy-buffers"] = CopyPipeline::DEFAULT_DEPTH;
+            updateJson            = true;
+        }
+        if (!(mJson.contains("copy-buffer-size") && mJson["copy-buffer-size"].is_number_unsigned())) {
+            mJson["copy-buffer-size"] = CopyPipeline::DEFAULT_BUFFER_SIZE;
+            updateJson                = true;
+        }
+        if (!(mJson.contains("backup-format") && mJson["backup-format"].is_string() &&
+                (mJson["backup-format"] == "files" || mJson["backup-format"] == "chunks" || mJson["backup-format"] == "bundle"))) {
+            mJson["backup-format"] = "files";
+            updateJson             = true;
+        }
         if (!(mJson.contains("filter") && mJson["filter"].is_array())) {
             mJson["filter"] = nlohmann::json::array();
             updateJson      = true;
@@ -215,6 +229,15 @@ std::vector<std::string> Configuration::additionalSaveFolders(u64 id)
     return folders == mAdditionalSaveFolders.end() ? emptyvec : folders->second;
 }
 
+std::vector<std::string> Configuration::additionalSaveFolders(void)
+{
+    std::vector<std::string> all;
+    for (const auto& [id, folders] : mAdditionalSaveFolders) {
+        all.insert(all.end(), folders.begin(), folders.end());
+    }
+    return all;
+}
+
 bool Configuration::isPKSMBridgeEnabled(void)
 {
     return PKSMBridgeEnabled;
@@ -280,6 +303,12 @@ void Configuration::parse(void)
     PKSMBridgeEnabled = mJson["pksm-bridge"];
     // parse FTP flag
     FTPEnabled = mJson["ftp-enabled"];
+    // parse copy pipeline tunables, keeping them within sane bounds for the heap
+    mCopyBufferCount = std::clamp<size_t>(mJson["copy-buffers"].get<size_t>(), 2, 16);
+    mCopyBufferSize  = std::clamp<size_t>(mJson["copy-buffer-size"].get<size_t>(), 0x4000, 0x400000);
+    // parse backup storage format
+    mChunkedBackups = mJson["backup-format"] == "chunks";
+    mBundledBackups = mJson["backup-format"] == "bundle";
 }
 
 const char* Configuration::c_str(void)
@@ -296,3 +325,23 @@ bool Configuration::isFTPEnabled(void)
 {
     return FTPEnabled;
 }
+
+size_t Configuration::copyBufferCount(void)
+{
+    return mCopyBufferCount;
+}
+
+size_t Configuration::copyBufferSize(void)
+{
+    return mCopyBufferSize;
+}
+
+bool Configuration::chunkedBackups(void)
+{
+    return mChunkedBackups;
+}
+
+bool Configuration::bundledBackups(void)
+{
+    return mBundledBackups;
+}
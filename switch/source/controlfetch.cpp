@@ -0,0 +1,148 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "controlfetch.hpp"
+#include "logging.hpp"
+#include <algorithm>
+#include <memory>
+
+// the highest version among the base game, its update and its add-ons, so any of them changing is noticed
+static bool applicationVersion(u64 id, u32& version)
+{
+    NsApplicationContentMetaStatus statuses[16];
+    s32 count = 0;
+    if (R_FAILED(nsListApplicationContentMetaStatus(id, 0, statuses, 16, &count)) || count <= 0) {
+        return false;
+    }
+    version = 0;
+    for (s32 i = 0; i < count; i++) {
+        version = std::max(version, statuses[i].version);
+    }
+    return true;
+}
+
+ControlFetch::ControlFetch(size_t workers, std::unordered_map<u64, u32> cachedVersions)
+    : mCachedVersions(std::move(cachedVersions)), mClosed(false)
+{
+    // if no thread can be started, finish() does all the fetching on the calling thread
+    mThreads.reserve(workers);
+    for (size_t i = 0; i < workers; i++) {
+        Thread thread;
+        if (R_FAILED(threadCreate(&thread, workerThread, this, nullptr, 0x8000, 0x2C, -2))) {
+            break;
+        }
+        threadStart(&thread);
+        mThreads.push_back(thread);
+    }
+}
+
+ControlFetch::~ControlFetch()
+{
+    finish();
+}
+
+void ControlFetch::request(u64 id)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mRequested.insert(id).second) {
+        mQueue.push_back(id);
+        mCond.notify_one();
+    }
+}
+
+void ControlFetch::finish(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mClosed) {
+            return;
+        }
+        mClosed = true;
+        mCond.notify_all();
+    }
+
+    work();
+    for (auto& thread : mThreads) {
+        threadWaitForExit(&thread);
+        threadClose(&thread);
+    }
+    mThreads.clear();
+}
+
+ControlFetch::Entry* ControlFetch::get(u64 id)
+{
+    auto it = mEntries.find(id);
+    return it != mEntries.end() ? &it->second : nullptr;
+}
+
+void ControlFetch::workerThread(void* arg)
+{
+    static_cast<ControlFetch*>(arg)->work();
+}
+
+void ControlFetch::work(void)
+{
+    // one buffer per worker, the icon is a JPEG of up to 0x20000 bytes
+    std::unique_ptr<NsApplicationControlData> nsacd(new NsApplicationControlData);
+    while (true) {
+        u64 id;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCond.wait(lock, [this] { return !mQueue.empty() || mClosed; });
+            if (mQueue.empty()) {
+                return;
+            }
+            id = mQueue.front();
+            mQueue.pop_front();
+        }
+
+        u32 version          = 0;
+        const bool versioned = applicationVersion(id, version);
+        auto cached          = mCachedVersions.find(id);
+        if (versioned && cached != mCachedVersions.end() && cached->second == version) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mEntries.emplace(id, Entry{version, true, {}, {}, {}});
+            continue;
+        }
+
+        size_t outsize         = 0;
+        NacpLanguageEntry* nle = NULL;
+        Result res             = nsGetApplicationControlData(NsApplicationControlSource_Storage, id, nsacd.get(), sizeof(*nsacd), &outsize);
+        if (R_FAILED(res) || outsize < sizeof(nsacd->nacp)) {
+            Logging::debug("Failed to get the control data of 0x{:016X} with result 0x{:08X}.", id, res);
+            continue;
+        }
+        res = nacpGetLanguageEntry(&nsacd->nacp, &nle);
+        if (R_FAILED(res) || nle == NULL) {
+            continue;
+        }
+
+        Entry entry = {version, false, std::string(nle->name), std::string(nle->author),
+            std::vector<u8>(nsacd->icon, nsacd->icon + outsize - sizeof(nsacd->nacp))};
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEntries.emplace(id, std::move(entry));
+    }
+}
@@ -0,0 +1,157 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "copypipeline.hpp"
+
+CopyPipeline::CopyPipeline(size_t depth, size_t bufferSize) : mBufferSize(bufferSize)
+{
+    mSlots.resize(depth < 2 ? 2 : depth);
+    for (auto& slot : mSlots) {
+        slot.data = std::unique_ptr<u8[]>(new u8[mBufferSize]);
+        slot.size = 0;
+    }
+    resetStats();
+}
+
+void CopyPipeline::resetStats(void)
+{
+    mBytes     = 0;
+    mElapsedNs = 0;
+}
+
+double CopyPipeline::bytesPerSecond(void) const
+{
+    return mElapsedNs == 0 ? 0.0 : (double)mBytes * 1000000000.0 / (double)mElapsedNs;
+}
+
+void CopyPipeline::readerThread(void* arg)
+{
+    static_cast<CopyPipeline*>(arg)->produce();
+}
+
+void CopyPipeline::produce(void)
+{
+    while (true) {
+        size_t slot;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCond.wait(lock, [this] { return mFilled < mSlots.size() || mAbort; });
+            if (mAbort) {
+                return;
+            }
+            slot = mHead;
+        }
+
+        // the slot at mHead is not visible to the consumer until mFilled is bumped, so the read
+        // can happen without holding the lock
+        size_t rd = fread(mSlots[slot].data.get(), 1, mBufferSize, mSrc);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (rd == 0) {
+            mEof = true;
+            mCond.notify_all();
+            return;
+        }
+        mSlots[slot].size = rd;
+        mHead             = (mHead + 1) % mSlots.size();
+        mFilled++;
+        mCond.notify_all();
+    }
+}
+
+bool CopyPipeline::copy(FILE* src, FILE* dst, const std::function<void(size_t)>& onChunk)
+{
+    const u64 start = armTicksToNs(armGetSystemTick());
+
+    mSrc    = src;
+    mHead   = 0;
+    mTail   = 0;
+    mFilled = 0;
+    mEof    = false;
+    mAbort  = false;
+
+    fseek(src, 0, SEEK_END);
+    const long size = ftell(src);
+    rewind(src);
+
+    // a file that fits in one buffer gains nothing from the reader thread, and if no thread is
+    // available we still want the copy to happen: both go through a plain read/write loop
+    Thread reader;
+    if (size <= (long)mBufferSize || R_FAILED(threadCreate(&reader, readerThread, this, nullptr, 0x4000, 0x2C, -2))) {
+        bool ok = true;
+        size_t rd;
+        while (ok && (rd = fread(mSlots[0].data.get(), 1, mBufferSize, src)) > 0) {
+            ok = fwrite(mSlots[0].data.get(), 1, rd, dst) == rd;
+            mBytes += rd;
+            if (onChunk) {
+                onChunk(rd);
+            }
+        }
+        mElapsedNs += armTicksToNs(armGetSystemTick()) - start;
+        return ok;
+    }
+    threadStart(&reader);
+
+    bool ok = true;
+    while (true) {
+        size_t slot;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCond.wait(lock, [this] { return mFilled > 0 || mEof; });
+            if (mFilled == 0) {
+                break;
+            }
+            slot = mTail;
+        }
+
+        size_t chunk = mSlots[slot].size;
+        if (fwrite(mSlots[slot].data.get(), 1, chunk, dst) != chunk) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mAbort = true;
+            mCond.notify_all();
+            ok = false;
+            break;
+        }
+        mBytes += chunk;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTail = (mTail + 1) % mSlots.size();
+            mFilled--;
+            mCond.notify_all();
+        }
+
+        if (onChunk) {
+            onChunk(chunk);
+        }
+    }
+
+    threadWaitForExit(&reader);
+    threadClose(&reader);
+
+    mElapsedNs += armTicksToNs(armGetSystemTick()) - start;
+    return ok;
+}
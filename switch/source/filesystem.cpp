@@ -25,6 +25,26 @@
  */
 
 #include "filesystem.hpp"
+#include "logging.hpp"
+#include "trace.hpp"
+
+namespace {
+    // journal space is taken in blocks, and every file touches at least one more block of metadata
+    constexpr u64 JOURNAL_BLOCK = 0x4000;
+
+    u64 journalBudget = 0;
+    u64 journalUsed   = 0;
+    size_t commits    = 0;
+
+    Result commitNow(void)
+    {
+        Trace::Span span("commit");
+        Result res  = fsdevCommitDevice("save");
+        journalUsed = 0;
+        commits++;
+        return res;
+    }
+}
 
 Result FileSystem::mount(FsFileSystem* fileSystem, u64 titleID, AccountUid userID)
 {
@@ -39,4 +59,40 @@ int FileSystem::mount(FsFileSystem fs)
 void FileSystem::unmount(void)
 {
     fsdevUnmountDevice("save");
-}
\ No newline at end of file
+}
+
+void FileSystem::beginCommits(u64 saveId)
+{
+    FsSaveDataExtraData extra;
+    Result res = fsReadSaveDataFileSystemExtraData(&extra, sizeof(extra), saveId);
+    // a quarter of the journal is kept as headroom for whatever the block estimate misses
+    journalBudget = R_SUCCEEDED(res) && extra.journal_size > 0 ? extra.journal_size / 4 * 3 : 0;
+    journalUsed   = 0;
+    commits       = 0;
+    if (journalBudget == 0) {
+        Logging::warning("Couldn't read the journal size of save 0x{:016X} (result 0x{:08X}), committing after every file.", saveId, res);
+    }
+}
+
+Result FileSystem::reserveJournal(u64 size)
+{
+    const u64 cost = (size + JOURNAL_BLOCK - 1) / JOURNAL_BLOCK * JOURNAL_BLOCK + JOURNAL_BLOCK;
+    Result res     = 0;
+    if (journalUsed > 0 && (journalBudget == 0 || journalUsed + cost > journalBudget)) {
+        res = commitNow();
+    }
+    journalUsed += cost;
+    return res;
+}
+
+Result FileSystem::commitJournal(void)
+{
+    return commitNow();
+}
+
+Result FileSystem::endCommits(void)
+{
+    Result res = journalUsed > 0 ? commitNow() : 0;
+    Logging::info("Save committed {} time(s) with a journal budget of 0x{:X} bytes.", commits, journalBudget);
+    return res;
+}
@@ -25,6 +25,11 @@
  */
 
 #include "io.hpp"
+#include "bundle.hpp"
+#include "chunkstore.hpp"
+#include "trace.hpp"
+#include <cstring>
+#include <unordered_map>
 
 bool io::fileExists(const std::string& path)
 {
@@ -32,105 +37,361 @@ bool io::fileExists(const std::string& path)
     return (stat(path.c_str(), &buffer) == 0);
 }
 
-size_t io::countFiles(const std::string& path)
+static Result walk(const std::string& root, const std::string& relative, io::Manifest& manifest)
 {
-    size_t count = 0;
-    Directory items(path);
+    Directory items(root + relative);
     if (!items.good()) {
-        return 0;
+        return items.error();
     }
+
     for (size_t i = 0, sz = items.size(); i < sz; i++) {
+        std::string path = relative + items.entry(i);
         if (items.folder(i)) {
-            count += io::countFiles(path + items.entry(i) + "/");
+            manifest.entries.push_back({path, 0, true});
+            Result res = walk(root, path + "/", manifest);
+            if (R_FAILED(res)) {
+                return res;
+            }
         }
         else {
-            count++;
+            struct stat st;
+            u64 size = stat((root + path).c_str(), &st) == 0 ? st.st_size : 0;
+            manifest.entries.push_back({path, size, false});
+            manifest.files++;
+            manifest.bytes += size;
         }
     }
-    return count;
+
+    return 0;
+}
+
+Result io::buildManifest(const std::string& root, io::Manifest& manifest)
+{
+    manifest.entries.clear();
+    manifest.files = 0;
+    manifest.bytes = 0;
+    return walk(root, "", manifest);
+}
+
+static std::unique_ptr<CopyPipeline> pipeline;
+
+// (re)builds the shared copy pipeline whenever the configured geometry changes
+static CopyPipeline& copyPipeline(void)
+{
+    const size_t depth      = Configuration::getInstance().copyBufferCount();
+    const size_t bufferSize = Configuration::getInstance().copyBufferSize();
+    if (!pipeline || pipeline->depth() != depth || pipeline->bufferSize() != bufferSize) {
+        pipeline = std::make_unique<CopyPipeline>(depth, bufferSize);
+    }
+    return *pipeline;
 }
 
-void io::copyFile(const std::string& srcPath, const std::string& dstPath)
+static void logThroughput(const std::string& mode)
 {
-    g_isTransferringFile = true;
+    if (pipeline && pipeline->bytes() > 0) {
+        Logging::info("{} copied {} bytes in {} ms ({:.2f} MiB/s, {} x 0x{:X} buffers).", mode, pipeline->bytes(), pipeline->elapsedMs(),
+            pipeline->bytesPerSecond() / (1024.0 * 1024.0), pipeline->depth(), pipeline->bufferSize());
+    }
+}
+
+namespace {
+    // publishes the transfer state to the UI for as long as a backup or restore is running
+    struct TransferScope {
+        TransferScope(const std::string& mode)
+        {
+            {
+                std::lock_guard<std::mutex> lock(g_transferMutex);
+                g_transferMode = mode;
+                g_currentFile.clear();
+            }
+            g_copyCount          = 0;
+            g_copyTotal          = 0;
+            g_copyBytes          = 0;
+            g_copyBytesTotal     = 0;
+            g_isTransferringFile = true;
+        }
+        ~TransferScope() { g_isTransferringFile = false; }
+    };
+}
+
+static void beginCopy(const io::Manifest& manifest)
+{
+    g_copyTotal      = manifest.files;
+    g_copyBytesTotal = manifest.bytes;
+    g_copyStartTime  = armTicksToNs(armGetSystemTick()) / 1000000;
+    copyPipeline().resetStats();
+}
 
+Result io::copyFile(const std::string& srcPath, const std::string& dstPath, u64 size)
+{
+    Trace::Span span("copyFile");
     FILE* src = fopen(srcPath.c_str(), "rb");
     if (src == NULL) {
-        Logging::error("Failed to open source file {} during copy with errno {}. Skipping...", srcPath, errno);
-        return;
+        Logging::error("Failed to open source file {} during copy with errno {}.", srcPath, errno);
+        return -1;
+    }
+    // make room in the save's journal before writing into it; the size comes from the manifest walk
+    if (dstPath.rfind("save:/", 0) == 0) {
+        Result res = FileSystem::reserveJournal(size);
+        if (R_FAILED(res)) {
+            Logging::error("Failed to commit save before writing {} with result 0x{:08X}.", dstPath, res);
+            fclose(src);
+            return res;
+        }
     }
+
     FILE* dst = fopen(dstPath.c_str(), "wb");
     if (dst == NULL) {
-        Logging::error("Failed to open destination file {} during copy with errno {}. Skipping...", dstPath, errno);
+        Logging::error("Failed to open destination file {} during copy with errno {}.", dstPath, errno);
         fclose(src);
-        return;
+        return -1;
     }
 
-    fseek(src, 0, SEEK_END);
-    u64 sz = ftell(src);
-    rewind(src);
-
-    u8* buf    = new u8[BUFFER_SIZE];
-    u64 offset = 0;
-
     size_t slashpos = srcPath.rfind("/");
-    g_currentFile   = srcPath.substr(slashpos + 1, srcPath.length() - slashpos - 1);
-
-    while (offset < sz) {
-        u32 count = fread((char*)buf, 1, BUFFER_SIZE, src);
-        fwrite((char*)buf, 1, count, dst);
-        offset += count;
+    {
+        std::lock_guard<std::mutex> lock(g_transferMutex);
+        g_currentFile = srcPath.substr(slashpos + 1, srcPath.length() - slashpos - 1);
+    }
 
-        // avoid freezing the UI
-        // this will be made less horrible next time...
-        g_screen->draw();
-        SDLH_Render();
+    bool ok = copyPipeline().copy(src, dst, [](size_t chunk) { g_copyBytes += chunk; });
+    if (!ok) {
+        Logging::error("Failed to write {} during copy with errno {}.", dstPath, errno);
     }
 
-    delete[] buf;
     fclose(src);
-    fclose(dst);
+    ok = fclose(dst) == 0 && ok;
     g_copyCount++;
+    return ok ? 0 : -1;
+}
 
-    // commit each file to the save
-    if (dstPath.rfind("save:/", 0) == 0) {
-        Logging::error("Committing file {} to the save archive.", dstPath);
-        fsdevCommitDevice("save");
+Result io::copyDirectory(const std::string& srcPath, const std::string& dstPath)
+{
+    io::Manifest manifest;
+    Result res = io::buildManifest(srcPath, manifest);
+    return R_SUCCEEDED(res) ? io::copyManifest(manifest, srcPath, dstPath) : res;
+}
+
+Result io::copyManifest(const io::Manifest& manifest, const std::string& srcPath, const std::string& dstPath)
+{
+    for (const auto& entry : manifest.entries) {
+        if (entry.directory) {
+            Result res = io::createDirectory(dstPath + entry.path);
+            if (R_FAILED(res)) {
+                return res;
+            }
+        }
+        else {
+            // a file left out would be missing from the snapshot, so the first failure stops the copy
+            Result res = io::copyFile(srcPath + entry.path, dstPath + entry.path, entry.size);
+            if (R_FAILED(res)) {
+                return res;
+            }
+        }
     }
 
-    g_isTransferringFile = false;
+    return 0;
 }
 
-Result io::copyDirectory(const std::string& srcPath, const std::string& dstPath)
+// Streams the manifest into a single bundle file. Unlike a folder copy a file can't just be skipped,
+// since the index written up front already promised its body.
+static Result writeBundle(const io::Manifest& manifest, const std::string& srcPath, const std::string& dstPath)
 {
-    Result res = 0;
-    bool quit  = false;
-    Directory items(srcPath);
+    FILE* out = fopen(dstPath.c_str(), "wb");
+    if (out == NULL) {
+        Logging::error("Failed to create bundle {} with errno {}.", dstPath, errno);
+        return -1;
+    }
 
-    if (!items.good()) {
-        return items.error();
+    Bundle::Writer writer([out](const void* data, size_t size) { return fwrite(data, 1, size, out) == size; });
+    std::vector<Bundle::Entry> entries;
+    for (const auto& entry : manifest.entries) {
+        entries.push_back({entry.path, entry.size, entry.directory});
     }
 
-    for (size_t i = 0, sz = items.size(); i < sz && !quit; i++) {
-        std::string newsrc = srcPath + items.entry(i);
-        std::string newdst = dstPath + items.entry(i);
+    bool ok = writer.writeIndex(entries);
+    for (auto it = manifest.entries.begin(); ok && it != manifest.entries.end(); ++it) {
+        if (it->directory) {
+            continue;
+        }
 
-        if (items.folder(i)) {
-            res = io::createDirectory(newdst);
-            if (R_SUCCEEDED(res)) {
-                newsrc += "/";
-                newdst += "/";
-                res = io::copyDirectory(newsrc, newdst);
+        std::string path = srcPath + it->path;
+        FILE* src        = fopen(path.c_str(), "rb");
+        if (src == NULL) {
+            Logging::error("Failed to open source file {} during backup with errno {}.", path, errno);
+            ok = false;
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_transferMutex);
+            g_currentFile = it->path.substr(it->path.rfind("/") + 1);
+        }
+
+        ok = writer.writeFile([src](void* data, size_t size) { return fread(data, 1, size, src); }, it->size,
+            [](size_t block) { g_copyBytes += block; });
+        fclose(src);
+        g_copyCount++;
+    }
+
+    ok = writer.finish() && ok;
+    ok = fclose(out) == 0 && ok;
+    return ok ? 0 : -1;
+}
+
+// Restores a bundle into dstPath. The index is read before dstPath is wiped, so a bundle that can't
+// be opened leaves the save as it was.
+static Result restoreBundle(const std::string& srcPath, const std::string& dstPath)
+{
+    FILE* in = fopen(srcPath.c_str(), "rb");
+    if (in == NULL) {
+        Logging::error("Failed to open bundle {} with errno {}.", srcPath, errno);
+        return -1;
+    }
+
+    Bundle::Reader reader([in](void* data, size_t size) { return fread(data, 1, size, in); });
+    std::vector<Bundle::Entry> entries;
+    io::Manifest manifest;
+    if (!reader.readIndex(entries)) {
+        fclose(in);
+        Logging::error("Bundle {} has an unreadable index.", srcPath);
+        return -1;
+    }
+    for (const auto& entry : entries) {
+        manifest.entries.push_back({entry.path, entry.size, entry.directory});
+        manifest.files += entry.directory ? 0 : 1;
+        manifest.bytes += entry.size;
+    }
+
+    // the wipe never reserved any journal space, so it is committed on its own before the first write
+    Result res = io::deleteFolderRecursively(dstPath.c_str());
+    if (R_SUCCEEDED(res)) {
+        res = FileSystem::commitJournal();
+    }
+    if (R_SUCCEEDED(res)) {
+        beginCopy(manifest);
+    }
+    for (auto it = entries.begin(); R_SUCCEEDED(res) && it != entries.end(); ++it) {
+        std::string path = dstPath + it->path;
+        if (it->directory) {
+            io::createDirectory(path);
+            continue;
+        }
+
+        res = FileSystem::reserveJournal(it->size);
+        if (R_FAILED(res)) {
+            Logging::error("Failed to commit save before writing {} with result 0x{:08X}.", path, res);
+            break;
+        }
+        FILE* out = fopen(path.c_str(), "wb");
+        if (out == NULL) {
+            Logging::error("Failed to open destination file {} during restore with errno {}.", path, errno);
+            res = -1;
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_transferMutex);
+            g_currentFile = it->path.substr(it->path.rfind("/") + 1);
+        }
+
+        bool ok = reader.readFile([out](const void* data, size_t size) { return fwrite(data, 1, size, out) == size; }, it->size,
+            [](size_t block) { g_copyBytes += block; });
+        fclose(out);
+        if (!ok) {
+            Logging::error("Failed to restore {} from bundle {}.", it->path, srcPath);
+            res = -1;
+            break;
+        }
+        g_copyCount++;
+    }
+
+    fclose(in);
+    return res;
+}
+
+static bool sameContents(const std::string& first, const std::string& second)
+{
+    FILE* a   = fopen(first.c_str(), "rb");
+    FILE* b   = fopen(second.c_str(), "rb");
+    bool same = a != NULL && b != NULL;
+    if (same) {
+        std::vector<u8> bufA(0x10000), bufB(0x10000);
+        size_t rdA, rdB;
+        do {
+            rdA  = fread(bufA.data(), 1, bufA.size(), a);
+            rdB  = fread(bufB.data(), 1, bufB.size(), b);
+            same = rdA == rdB && memcmp(bufA.data(), bufB.data(), rdA) == 0 && !ferror(a) && !ferror(b);
+        } while (same && rdA > 0);
+    }
+    if (a != NULL) {
+        fclose(a);
+    }
+    if (b != NULL) {
+        fclose(b);
+    }
+    return same;
+}
+
+Result io::syncManifest(const io::Manifest& manifest, const std::string& srcPath, const std::string& dstPath)
+{
+    io::Manifest live;
+    Result res = io::buildManifest(dstPath, live);
+    if (R_FAILED(res)) {
+        return res;
+    }
+
+    std::unordered_map<std::string, const io::ManifestEntry*> wanted, existing;
+    for (const auto& entry : manifest.entries) {
+        wanted.emplace(entry.path, &entry);
+    }
+    for (const auto& entry : live.entries) {
+        existing.emplace(entry.path, &entry);
+    }
+
+    // children come after their parents in a manifest, so walking it backwards empties folders before removing them
+    size_t deleted = 0;
+    for (auto it = live.entries.rbegin(); it != live.entries.rend(); ++it) {
+        auto match = wanted.find(it->path);
+        if (match == wanted.end() || match->second->directory != it->directory) {
+            std::string path = dstPath + it->path;
+            if (dstPath.rfind("save:/", 0) == 0) {
+                res = FileSystem::reserveJournal(0);
+                if (R_FAILED(res)) {
+                    return res;
+                }
+            }
+            if (it->directory) {
+                rmdir(path.c_str());
             }
             else {
-                quit = true;
+                std::remove(path.c_str());
             }
+            existing.erase(it->path);
+            deleted++;
         }
-        else {
-            io::copyFile(newsrc, newdst);
+    }
+
+    size_t written = 0;
+    for (const auto& entry : manifest.entries) {
+        auto current = existing.find(entry.path);
+        if (entry.directory) {
+            if (current == existing.end()) {
+                io::createDirectory(dstPath + entry.path);
+            }
+            continue;
+        }
+
+        if (current != existing.end() && current->second->size == entry.size && sameContents(srcPath + entry.path, dstPath + entry.path)) {
+            g_copyBytes += entry.size;
+            g_copyCount++;
+            continue;
+        }
+        res = io::copyFile(srcPath + entry.path, dstPath + entry.path, entry.size);
+        if (R_FAILED(res)) {
+            return res;
         }
+        written++;
     }
 
+    Logging::info("Synced {}: {} of {} files written, {} entries deleted.", dstPath, written, manifest.files, deleted);
     return 0;
 }
 
@@ -170,13 +431,43 @@ Result io::deleteFolderRecursively(const std::string& path)
     return 0;
 }
 
-std::tuple<bool, Result, std::string> io::backup(size_t index, AccountUid uid, size_t cellIndex)
+std::string io::suggestedBackupName(AccountUid uid)
+{
+    const std::string username = Account::username(uid);
+    return DateTime::dateTimeStr() + " " +
+           (StringUtils::containsInvalidChar(username) ? "" : StringUtils::removeNotAscii(StringUtils::removeAccents(username)));
+}
+
+std::pair<bool, std::string> io::backupName(AccountUid uid, size_t cellIndex)
 {
+    if (cellIndex != 0) {
+        // we're overriding an existing folder
+        return std::make_pair(true, "");
+    }
+
+    std::string suggestion = io::suggestedBackupName(uid);
+    if (!KeyboardManager::get().isSystemKeyboardAvailable().first) {
+        return std::make_pair(true, suggestion);
+    }
+
+    std::pair<bool, std::string> keyboardResponse = KeyboardManager::get().keyboard(suggestion);
+    if (!keyboardResponse.first) {
+        Logging::info("Copy operation aborted by the user through the system keyboard.");
+        return std::make_pair(false, "");
+    }
+    return std::make_pair(true, StringUtils::removeForbiddenCharacters(keyboardResponse.second));
+}
+
+std::tuple<bool, Result, std::string> io::backup(size_t index, AccountUid uid, size_t cellIndex, const std::string& customPath)
+{
+    Trace::Span span("backup");
+
     const bool isNewFolder                    = cellIndex == 0;
     Result res                                = 0;
     std::tuple<bool, Result, std::string> ret = std::make_tuple(false, -1, "");
     Title title;
     getTitle(title, uid, index);
+    TransferScope scope("Backup");
 
     Logging::info("Started backup of {}. Title id: 0x{:016X}; User id: 0x{:X}{:X}.", title.name().c_str(), title.id(), title.userId().uid[1],
         title.userId().uid[0]);
@@ -198,48 +489,32 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, AccountUid uid, s
         return std::make_tuple(false, res, "Failed to mount save.");
     }
 
-    std::string suggestion = DateTime::dateTimeStr() + " " +
-                             (StringUtils::containsInvalidChar(Account::username(title.userId()))
-                                     ? ""
-                                     : StringUtils::removeNotAscii(StringUtils::removeAccents(Account::username(title.userId()))));
-    std::string customPath;
-
-    if (MS::multipleSelectionEnabled()) {
-        customPath = isNewFolder ? suggestion : "";
-    }
-    else {
-        if (isNewFolder) {
-            if (KeyboardManager::get().isSystemKeyboardAvailable().first) {
-                std::pair<bool, std::string> keyboardResponse = KeyboardManager::get().keyboard(suggestion);
-                if (keyboardResponse.first) {
-                    customPath = StringUtils::removeForbiddenCharacters(keyboardResponse.second);
-                }
-                else {
-                    FileSystem::unmount();
-                    Logging::info("Copy operation aborted by the user through the system keyboard.");
-                    return std::make_tuple(false, 0, "Operation aborted by the user.");
-                }
-            }
-            else {
-                customPath = suggestion;
-            }
-        }
-        else {
-            customPath = "";
-        }
-    }
-
     std::string dstPath;
     if (!isNewFolder) {
-        // we're overriding an existing folder
+        // we're overriding an existing backup, which may have been written in another format
         dstPath = title.fullPath(cellIndex);
+        if (Bundle::hasExtension(dstPath) && !io::directoryExists(dstPath)) {
+            dstPath.erase(dstPath.length() - strlen(Bundle::EXTENSION));
+        }
     }
     else {
+        // the folder of a title is only made once something is backed up into it
+        if (!io::directoryExists(title.path())) {
+            io::createDirectory(title.path());
+        }
         dstPath = title.path() + "/" + customPath;
     }
 
-    if (!isNewFolder || io::directoryExists(dstPath)) {
-        int rc = io::deleteFolderRecursively((dstPath + "/").c_str());
+    const bool bundled           = Configuration::getInstance().bundledBackups();
+    const std::string bundlePath = dstPath + Bundle::EXTENSION;
+    if (io::fileExists(bundlePath) && !io::directoryExists(bundlePath)) {
+        std::remove(bundlePath.c_str());
+    }
+
+    bool replacedChunks = false;
+    if (io::directoryExists(dstPath)) {
+        replacedChunks = ChunkStore::isChunked(dstPath);
+        int rc         = io::deleteFolderRecursively((dstPath + "/").c_str());
         if (rc != 0) {
             FileSystem::unmount();
             Logging::error("Failed to recursively delete directory {} with result {}.", dstPath, rc);
@@ -247,25 +522,42 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, AccountUid uid, s
         }
     }
 
-    io::createDirectory(dstPath);
-    g_copyCount    = 0;
-    g_copyTotal    = io::countFiles("save:/");
-    g_transferMode = "Backup";
-    res            = io::copyDirectory("save:/", dstPath + "/");
+    io::Manifest manifest;
+    res = io::buildManifest("save:/", manifest);
+    if (R_SUCCEEDED(res)) {
+        beginCopy(manifest);
+        if (bundled) {
+            res = writeBundle(manifest, "save:/", bundlePath);
+        }
+        else {
+            io::createDirectory(dstPath);
+            if (Configuration::getInstance().chunkedBackups()) {
+                res = ChunkStore::backup(manifest, "save:/", dstPath);
+            }
+            else {
+                res = io::copyManifest(manifest, "save:/", dstPath + "/");
+            }
+        }
+    }
     if (R_FAILED(res)) {
         FileSystem::unmount();
-        io::deleteFolderRecursively((dstPath + "/").c_str());
+        if (bundled) {
+            std::remove(bundlePath.c_str());
+        }
+        else {
+            io::deleteFolderRecursively((dstPath + "/").c_str());
+        }
         Logging::error("Failed to copy directory {} with result 0x{:08X}. Skipping...", dstPath, res);
         return std::make_tuple(false, res, "Failed to backup save.");
     }
 
+    logThroughput("Backup");
+    if (replacedChunks) {
+        ChunkStore::collectGarbage();
+    }
     refreshDirectories(title.id());
 
     FileSystem::unmount();
-    if (!MS::multipleSelectionEnabled()) {
-        blinkLed(4);
-        ret = std::make_tuple(true, 0, "Progress correctly saved to disk.");
-    }
 
     auto systemKeyboardAvailable = KeyboardManager::get().isSystemKeyboardAvailable();
     if (!systemKeyboardAvailable.first) {
@@ -280,10 +572,13 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, AccountUid uid, s
 
 std::tuple<bool, Result, std::string> io::restore(size_t index, AccountUid uid, size_t cellIndex, const std::string& nameFromCell)
 {
+    Trace::Span span("restore");
+
     Result res                                = 0;
     std::tuple<bool, Result, std::string> ret = std::make_tuple(false, -1, "");
     Title title;
     getTitle(title, uid, index);
+    TransferScope scope("Restore");
 
     Logging::info("Started restore of {}. Title id: 0x{:016X}; User id: 0x{:X}{:X}.", title.name().c_str(), title.id(), title.userId().uid[1],
         title.userId().uid[0]);
@@ -304,28 +599,61 @@ std::tuple<bool, Result, std::string> io::restore(size_t index, AccountUid uid,
             title.userId().uid[1], title.userId().uid[0]);
         return std::make_tuple(false, res, "Failed to mount save.");
     }
+    FileSystem::beginCommits(title.saveId());
 
     std::string srcPath = title.fullPath(cellIndex) + "/";
     std::string dstPath = "save:/";
 
-    res = io::deleteFolderRecursively(dstPath.c_str());
-    if (R_FAILED(res)) {
+    // read a chunked backup's manifest before the save is wiped, so an unreadable one leaves the save untouched
+    ChunkStore::Snapshot snapshot;
+    const bool chunked = ChunkStore::isChunked(title.fullPath(cellIndex));
+    if (chunked && R_FAILED(res = ChunkStore::load(title.fullPath(cellIndex), snapshot))) {
         FileSystem::unmount();
-        Logging::error("Failed to recursively delete directory {} with result 0x{:08X}.", dstPath, res);
-        return std::make_tuple(false, res, "Failed to delete save.");
+        return std::make_tuple(false, res, "Failed to read the backup manifest.");
     }
 
-    g_copyCount    = 0;
-    g_copyTotal    = io::countFiles(srcPath);
-    g_transferMode = "Restore";
-    res            = io::copyDirectory(srcPath, dstPath);
+    // chunked backups are rewritten from scratch, bundles wipe the save themselves once their index has been
+    // read, and folder backups are synced file by file
+    const bool bundled = Bundle::hasExtension(title.fullPath(cellIndex)) && !io::directoryExists(title.fullPath(cellIndex));
+    if (chunked) {
+        res = io::deleteFolderRecursively(dstPath.c_str());
+        if (R_FAILED(res)) {
+            FileSystem::unmount();
+            Logging::error("Failed to recursively delete directory {} with result 0x{:08X}.", dstPath, res);
+            return std::make_tuple(false, res, "Failed to delete save.");
+        }
+        // the wipe never reserved any journal space, so it is committed on its own before the first write
+        res = FileSystem::commitJournal();
+        if (R_FAILED(res)) {
+            FileSystem::unmount();
+            Logging::error("Failed to commit save with result 0x{:08X}.", res);
+            return std::make_tuple(false, res, "Failed to commit to save device.");
+        }
+    }
+
+    if (bundled) {
+        res = restoreBundle(title.fullPath(cellIndex), dstPath);
+    }
+    else if (chunked) {
+        beginCopy(snapshot.manifest);
+        res = ChunkStore::restore(snapshot, dstPath);
+    }
+    else {
+        io::Manifest manifest;
+        res = io::buildManifest(srcPath, manifest);
+        if (R_SUCCEEDED(res)) {
+            beginCopy(manifest);
+            res = io::syncManifest(manifest, srcPath, dstPath);
+        }
+    }
     if (R_FAILED(res)) {
         FileSystem::unmount();
-        Logging::error("Failed to copy directory {} to {} with result 0x{:08X}. Skipping...", srcPath, dstPath, res);
+        Logging::error("Failed to copy directory {} to {} with result 0x{:08X}.", srcPath, dstPath, res);
         return std::make_tuple(false, res, "Failed to restore save.");
     }
 
-    res = fsdevCommitDevice("save");
+    logThroughput("Restore");
+    res = FileSystem::endCommits();
     if (R_FAILED(res)) {
         Logging::error("Failed to commit save with result 0x{:08X}.", res);
         return std::make_tuple(false, res, "Failed to commit to save device.");
@@ -339,4 +667,18 @@ std::tuple<bool, Result, std::string> io::restore(size_t index, AccountUid uid,
 
     Logging::info("Restore succeeded.");
     return ret;
-}
\ No newline at end of file
+}
+
+void io::deleteBackupFolder(const std::string& path)
+{
+    if (Bundle::hasExtension(path) && !io::directoryExists(path)) {
+        std::remove(path.c_str());
+        return;
+    }
+
+    const bool chunked = ChunkStore::isChunked(path);
+    io::deleteFolderRecursively((path + "/").c_str());
+    if (chunked) {
+        ChunkStore::collectGarbage();
+    }
+}
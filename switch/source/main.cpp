@@ -70,18 +70,27 @@ int main(void)
         padUpdate(&pad);
 
         input.kDown = padGetButtonsDown(&pad);
-        if (input.kDown & HidNpadButton_Plus)
+        if ((input.kDown & HidNpadButton_Plus) && !Job::running())
             break;
 
         input.kHeld = padGetButtons(&pad);
         input.kUp   = padGetButtonsUp(&pad);
         hidGetTouchScreenStates(&input.touch, 1);
 
-        g_screen->doDraw();
-        g_screen->doUpdate(input);
-        SDLH_Render();
+        if (g_screen->frameDue(input.kDown || input.kHeld || input.kUp || input.touch.count > 0)) {
+            g_screen->doDraw();
+            g_screen->doUpdate(input);
+            SDLH_Render();
+        }
+        else {
+            // the last frame stays on screen, only the pace of the loop is kept
+            g_screen->doUpdate(input);
+            svcSleepThread(1000000000ULL / 60);
+        }
     }
 
+    Job::wait();
+
     g_shouldExitNetworkLoop = true;
     threadWaitForExit(&networkThread);
     threadClose(&networkThread);
@@ -25,6 +25,7 @@
  */
 
 #include "pksmbridge.hpp"
+#include "chunkstore.hpp"
 
 static bool isLGPE(u64 id)
 {
@@ -68,18 +69,31 @@ std::tuple<bool, Result, std::string> sendToPKSMBrigde(size_t index, AccountUid
         return std::make_tuple(false, systemKeyboardAvailable.second, "Invalid title.");
     }
 
+    size_t size;
+    char* data;
     std::string srcPath = title.fullPath(cellIndex) + filename;
-    FILE* save          = fopen(srcPath.c_str(), "rb");
-    if (save == NULL) {
-        return std::make_tuple(false, systemKeyboardAvailable.second, "Failed to open source file.");
+    if (ChunkStore::isChunked(title.fullPath(cellIndex))) {
+        std::vector<u8> contents;
+        if (!ChunkStore::readFile(title.fullPath(cellIndex), filename.substr(1), contents)) {
+            return std::make_tuple(false, systemKeyboardAvailable.second, "Failed to open source file.");
+        }
+        size = contents.size();
+        data = new char[size];
+        memcpy(data, contents.data(), size);
     }
+    else {
+        FILE* save = fopen(srcPath.c_str(), "rb");
+        if (save == NULL) {
+            return std::make_tuple(false, systemKeyboardAvailable.second, "Failed to open source file.");
+        }
 
-    fseek(save, 0, SEEK_END);
-    size_t size = ftell(save);
-    rewind(save);
-    char* data = new char[size];
-    fread(data, 1, size, save);
-    fclose(save);
+        fseek(save, 0, SEEK_END);
+        size = ftell(save);
+        rewind(save);
+        data = new char[size];
+        fread(data, 1, size, save);
+        fclose(save);
+    }
 
     // get server address
     auto ipaddress = KeyboardManager::get().keyboard("Input PKSM IP address");
@@ -208,6 +222,11 @@ std::tuple<bool, Result, std::string> recvFromPKSMBridge(size_t index, AccountUi
         fwrite(data, 1, size, save);
         fclose(save);
         delete[] data;
+        // a chunked backup only restores what its manifest lists, so move the received file into the store
+        if (ChunkStore::isChunked(title.fullPath(cellIndex)) && R_FAILED(ChunkStore::importFile(title.fullPath(cellIndex), filename.substr(1)))) {
+            Logging::error("Failed to import received pksmbridge data into the chunk store.");
+            return std::make_tuple(false, -1, "Failed to store received data.");
+        }
         Logging::info("pksmbridge data received correctly.");
         return std::make_tuple(true, 0, "Data received correctly.");
     }
@@ -25,46 +25,186 @@
  */
 
 #include "title.hpp"
+#include "bundle.hpp"
+#include "controlfetch.hpp"
+#include "titlecache.hpp"
+#include "trace.hpp"
+#include <atomic>
+#include <mutex>
+#include <numeric>
+
+static constexpr u16 NEW_BACKUP = 0xFFFF;
+
+// 64 entries of 0x60 bytes, one IPC round trip each
+static constexpr size_t SAVE_INFO_BATCH = 64;
 
 static std::unordered_map<AccountUid, std::vector<Title>> titles;
 static std::unordered_map<u64, SDL_Texture*> icons;
+// icons of titles taken from the title cache, read from it the first time they are drawn
+struct IconSource {
+    u64 offset;
+    u16 width;
+    u16 height;
+};
+static std::unordered_map<u64, IconSource> iconSources;
+// titles is read by the UI while backup/restore jobs refresh it from their own thread
+static std::mutex titlesMutex;
+// bumped whenever titles is replaced or reordered, which invalidates every index into it
+static u32 titlesGeneration = 0;
+// applications whose backups are listed in the background once the titles are loaded
+static std::vector<std::shared_ptr<const TitleInfo>> backupScanQueue;
+static Thread backupScanThread;
+static bool backupScanStarted = false;
+static std::atomic<bool> backupScanStop{false};
+
+struct SortKey {
+    bool favorite;
+    u32 lastPlayed;
+    u64 playTime;
+    std::string name;
+};
 
 void freeIcons(void)
 {
     for (auto& i : icons) {
-        SDL_DestroyTexture(i.second);
+        if (i.second != NULL) {
+            SDL_DestroyTexture(i.second);
+        }
     }
     icons.clear();
+    iconSources.clear();
 }
 
-static void loadIcon(u64 id, NsApplicationControlData* nsacd, size_t iconsize)
+static SDL_Texture* loadIcon(u64 id, std::vector<u8>& pixels, int w, int h)
 {
-    auto it = icons.find(id);
-    if (it == icons.end()) {
-        SDL_Texture* texture;
-        SDLH_LoadImage(&texture, nsacd->icon, iconsize);
+    SDL_Texture* texture = NULL;
+    SDLH_LoadPixels(&texture, pixels.data(), w, h);
+    if (texture != NULL) {
         SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
-        icons.insert({id, texture});
     }
+    icons.insert({id, texture});
+    return texture;
+}
+
+static SDL_Texture* iconTexture(u64 id)
+{
+    auto it = icons.find(id);
+    if (it != icons.end()) {
+        return it->second;
+    }
+
+    auto source = iconSources.find(id);
+    if (source == iconSources.end()) {
+        return NULL;
+    }
+    // a failed read is remembered as a missing icon rather than retried every frame
+    std::vector<u8> pixels;
+    const IconSource icon = source->second;
+    iconSources.erase(source);
+    if (!TitleCache::readIcon(icon.offset, icon.width, icon.height, pixels)) {
+        icons.insert({id, NULL});
+        return NULL;
+    }
+    return loadIcon(id, pixels, icon.width, icon.height);
+}
+
+static std::shared_ptr<const TitleInfo> makeTitleInfo(u64 id, const std::string& name, const std::string& author)
+{
+    const std::string safeName =
+        StringUtils::containsInvalidChar(name) ? StringUtils::format("0x%016llX", id) : StringUtils::removeForbiddenCharacters(name);
+
+    auto info         = std::make_shared<TitleInfo>();
+    info->id          = id;
+    info->name        = name;
+    info->author      = author;
+    info->displayName = StringUtils::removeAccents(name);
+    info->path        = "sdmc:/switch/Checkpoint/saves/" + StringUtils::format("0x%016llX", id) + " " + safeName;
+    info->backups     = std::make_shared<BackupList>();
+    return info;
 }
 
-void Title::init(u8 saveDataType, u64 id, AccountUid userID, const std::string& name, const std::string& author)
+// Lists the backups of an application into its backup list, whose mutex the caller holds
+static void listBackups(const TitleInfo& info)
+{
+    Trace::Span span("refreshDirectories");
+    BackupList& list = *info.backups;
+    list.saves.clear();
+    list.folders.clear();
+    list.additionalFolders.clear();
+
+    Directory savelist(info.path);
+    if (savelist.good()) {
+        for (size_t i = 0, sz = savelist.size(); i < sz; i++) {
+            if (savelist.folder(i) || Bundle::hasExtension(savelist.entry(i))) {
+                list.saves.push_back(savelist.entry(i));
+            }
+        }
+
+        std::sort(list.saves.rbegin(), list.saves.rend());
+        list.folders.assign(list.saves.size(), 0);
+        list.saves.insert(list.saves.begin(), "New...");
+        list.folders.insert(list.folders.begin(), NEW_BACKUP);
+    }
+    else if (!io::directoryExists(info.path)) {
+        // nothing was backed up yet, the folder is made along with the first backup
+        list.saves.push_back("New...");
+        list.folders.push_back(NEW_BACKUP);
+    }
+    else {
+        Logging::error("Couldn't retrieve the extdata directory list for the title {}", info.name);
+    }
+
+    // save backups from configuration
+    std::vector<std::string> additionalFolders = Configuration::getInstance().additionalSaveFolders(info.id);
+    for (std::vector<std::string>::const_iterator it = additionalFolders.begin(); it != additionalFolders.end(); ++it) {
+        // we have other folders to parse
+        Directory dir(*it);
+        if (dir.good()) {
+            list.additionalFolders.push_back(*it);
+            for (size_t i = 0, sz = dir.size(); i < sz; i++) {
+                if (dir.folder(i) || Bundle::hasExtension(dir.entry(i))) {
+                    list.saves.push_back(dir.entry(i));
+                    list.folders.push_back(list.additionalFolders.size());
+                }
+            }
+        }
+    }
+    list.listed = true;
+    list.generation++;
+}
+
+static void backupScan(void*)
+{
+    Trace::Span span("backupScan");
+    for (const std::shared_ptr<const TitleInfo>& info : backupScanQueue) {
+        if (backupScanStop) {
+            break;
+        }
+        std::lock_guard<std::mutex> lock(info->backups->mutex);
+        if (!info->backups->listed) {
+            listBackups(*info);
+        }
+    }
+}
+
+void stopBackupScan(void)
+{
+    if (backupScanStarted) {
+        backupScanStop = true;
+        threadWaitForExit(&backupScanThread);
+        threadClose(&backupScanThread);
+        backupScanStarted = false;
+    }
+    backupScanQueue.clear();
+}
+
+void Title::init(u8 saveDataType, u64 id, AccountUid userID, std::shared_ptr<const TitleInfo> info)
 {
     mId           = id;
     mUserId       = userID;
     mSaveDataType = saveDataType;
     mUserName     = Account::username(userID);
-    mAuthor       = author;
-    mName         = name;
-    mSafeName     = StringUtils::containsInvalidChar(name) ? StringUtils::format("0x%016llX", mId) : StringUtils::removeForbiddenCharacters(name);
-    mPath         = "sdmc:/switch/Checkpoint/saves/" + StringUtils::format("0x%016llX", mId) + " " + mSafeName;
-    mDisplayName  = StringUtils::removeAccents(mName);
-
-    if (!io::directoryExists(mPath)) {
-        io::createDirectory(mPath);
-    }
-
-    refreshDirectories();
+    mInfo         = std::move(info);
 }
 
 u8 Title::saveDataType(void)
@@ -99,38 +239,71 @@ std::string Title::userName(void)
 
 std::string Title::author(void)
 {
-    return mAuthor;
+    return mInfo ? mInfo->author : "";
 }
 
 std::string Title::name(void)
 {
-    return mName;
+    return mInfo ? mInfo->name : "";
 }
 
 std::string Title::displayName(void)
 {
-    return mDisplayName;
+    return mInfo ? mInfo->displayName : "";
 }
 
 std::string Title::path(void)
 {
-    return mPath;
+    return mInfo ? mInfo->path : "";
 }
 
 std::string Title::fullPath(size_t index)
 {
-    return mFullSavePaths.at(index);
+    BackupList& list = *mInfo->backups;
+    std::lock_guard<std::mutex> lock(list.mutex);
+    if (!list.listed) {
+        listBackups(*mInfo);
+    }
+
+    const u16 folder = list.folders.at(index);
+    if (folder == NEW_BACKUP) {
+        return list.saves.at(index);
+    }
+    return (folder == 0 ? path() : list.additionalFolders.at(folder - 1)) + "/" + list.saves.at(index);
 }
 
 std::vector<std::string> Title::saves()
 {
-    return mSaves;
+    if (!mInfo) {
+        return {};
+    }
+
+    // the first title to be selected may not have been reached by the background scan yet
+    BackupList& list = *mInfo->backups;
+    std::lock_guard<std::mutex> lock(list.mutex);
+    if (!list.listed) {
+        listBackups(*mInfo);
+    }
+    return list.saves;
+}
+
+u32 Title::backupsGeneration(void)
+{
+    if (!mInfo) {
+        return 0;
+    }
+
+    BackupList& list = *mInfo->backups;
+    std::lock_guard<std::mutex> lock(list.mutex);
+    if (!list.listed) {
+        listBackups(*mInfo);
+    }
+    return list.generation;
 }
 
 SDL_Texture* Title::icon(void)
 {
-    auto it = icons.find(mId);
-    return it != icons.end() ? it->second : NULL;
+    return iconTexture(mId);
 }
 
 u64 Title::playTimeNanoseconds(void)
@@ -161,137 +334,211 @@ void Title::lastPlayedTimestamp(u32 lastPlayedTimestamp)
 
 void Title::refreshDirectories(void)
 {
-    mSaves.clear();
-    mFullSavePaths.clear();
+    std::lock_guard<std::mutex> lock(mInfo->backups->mutex);
+    listBackups(*mInfo);
+}
 
-    Directory savelist(mPath);
-    if (savelist.good()) {
-        for (size_t i = 0, sz = savelist.size(); i < sz; i++) {
-            if (savelist.folder(i)) {
-                mSaves.push_back(savelist.entry(i));
-                mFullSavePaths.push_back(mPath + "/" + savelist.entry(i));
-            }
-        }
+// Lists the account saves that aren't filtered out and queues their applications on fetch. The reader is drained
+// SAVE_INFO_BATCH entries per IPC round trip instead of one.
+static Result enumerateSaves(std::vector<FsSaveDataInfo>& saves, ControlFetch& fetch)
+{
+    Trace::Span span("enumerateSaves");
+    const u64 start = armGetSystemTick();
 
-        std::sort(mSaves.rbegin(), mSaves.rend());
-        std::sort(mFullSavePaths.rbegin(), mFullSavePaths.rend());
-        mSaves.insert(mSaves.begin(), "New...");
-        mFullSavePaths.insert(mFullSavePaths.begin(), "New...");
-    }
-    else {
-        Logging::error("Couldn't retrieve the extdata directory list for the title {}", name());
+    FsSaveDataInfoReader reader;
+    Result res = fsOpenSaveDataInfoReader(&reader, FsSaveDataSpaceId_User);
+    if (R_FAILED(res)) {
+        Logging::error("Failed to open the save data info reader with result 0x{:08X}.", res);
+        return res;
     }
 
-    // save backups from configuration
-    std::vector<std::string> additionalFolders = Configuration::getInstance().additionalSaveFolders(mId);
-    for (std::vector<std::string>::const_iterator it = additionalFolders.begin(); it != additionalFolders.end(); ++it) {
-        // we have other folders to parse
-        Directory list(*it);
-        if (list.good()) {
-            for (size_t i = 0, sz = list.size(); i < sz; i++) {
-                if (list.folder(i)) {
-                    mSaves.push_back(list.entry(i));
-                    mFullSavePaths.push_back(*it + "/" + list.entry(i));
-                }
+    std::vector<FsSaveDataInfo> batch(SAVE_INFO_BATCH);
+    size_t total = 0;
+    while (1) {
+        s64 count = 0;
+        res       = fsSaveDataInfoReaderRead(&reader, batch.data(), batch.size(), &count);
+        if (R_FAILED(res) || count == 0) {
+            break;
+        }
+
+        total += count;
+        for (s64 i = 0; i < count; i++) {
+            if (batch[i].save_data_type == FsSaveDataType_Account && !Configuration::getInstance().filter(batch[i].application_id)) {
+                saves.push_back(batch[i]);
+                fetch.request(batch[i].application_id);
             }
         }
     }
+    fsSaveDataInfoReaderClose(&reader);
+
+    Logging::debug("Enumerated {} save data entries, {} of them account saves, in {} ms", total, saves.size(),
+        armTicksToNs(armGetSystemTick() - start) / 1000000);
+    return 0;
 }
 
 void loadTitles(void)
 {
-    titles.clear();
-
-    FsSaveDataInfoReader reader;
-    FsSaveDataInfo info;
-    s64 total_entries = 0;
-    size_t outsize    = 0;
-
-    NacpLanguageEntry* nle          = NULL;
-    NsApplicationControlData* nsacd = (NsApplicationControlData*)malloc(sizeof(NsApplicationControlData));
-    if (nsacd == NULL) {
-        return;
+    Trace::Span span("loadTitles");
+    stopBackupScan();
+    std::unordered_map<AccountUid, std::vector<Title>> loaded;
+
+    // applications already in the title cache at their installed version skip the control data entirely
+    std::unordered_map<u64, TitleCache::Entry> cache;
+    TitleCache::load(cache);
+    std::unordered_map<u64, u32> cachedVersions;
+    for (const auto& [id, entry] : cache) {
+        cachedVersions.emplace(id, entry.version);
     }
-    memset(nsacd, 0, sizeof(NsApplicationControlData));
 
-    Result res = fsOpenSaveDataInfoReader(&reader, FsSaveDataSpaceId_User);
+    // the control data of an application is fetched once, no matter how many users have a save for it
+    ControlFetch fetch(ControlFetch::DEFAULT_WORKERS, std::move(cachedVersions));
+    std::vector<FsSaveDataInfo> saves;
+    Result res = enumerateSaves(saves, fetch);
+    {
+        Trace::Span fetchSpan("fetchControlData");
+        fetch.finish();
+    }
     if (R_FAILED(res)) {
-        free(nsacd);
         return;
     }
 
-    while (1) {
-        res = fsSaveDataInfoReaderRead(&reader, &info, 1, &total_entries);
-        if (R_FAILED(res) || total_entries == 0) {
-            break;
+    std::unordered_map<u64, std::shared_ptr<const TitleInfo>> infos;
+    std::unordered_map<u64, TitleCache::Entry> current;
+    size_t fetched = 0;
+    for (const FsSaveDataInfo& info : saves) {
+        u64 tid                      = info.application_id;
+        u64 sid                      = info.save_data_id;
+        AccountUid uid               = info.uid;
+        ControlFetch::Entry* control = fetch.get(tid);
+        if (control == NULL) {
+            continue;
         }
 
-        if (info.save_data_type == FsSaveDataType_Account) {
-            u64 tid        = info.application_id;
-            u64 sid        = info.save_data_id;
-            AccountUid uid = info.uid;
-            if (!Configuration::getInstance().filter(tid)) {
-                res = nsGetApplicationControlData(NsApplicationControlSource_Storage, tid, nsacd, sizeof(NsApplicationControlData), &outsize);
-                if (R_SUCCEEDED(res) && !(outsize < sizeof(nsacd->nacp))) {
-                    res = nacpGetLanguageEntry(&nsacd->nacp, &nle);
-                    if (R_SUCCEEDED(res) && nle != NULL) {
-                        Title title;
-                        title.init(info.save_data_type, tid, uid, std::string(nle->name), std::string(nle->author));
-                        title.saveId(sid);
-
-                        // load play statistics
-                        PdmPlayStatistics stats;
-                        res = pdmqryQueryPlayStatisticsByApplicationIdAndUserAccountId(tid, uid, false, &stats);
-                        if (R_SUCCEEDED(res)) {
-                            title.playTimeNanoseconds(stats.playtime);
-                            title.lastPlayedTimestamp(stats.last_timestamp_user);
-                        }
-
-                        loadIcon(tid, nsacd, outsize - sizeof(nsacd->nacp));
-
-                        // check if the vector is already created
-                        std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-                        if (it != titles.end()) {
-                            // found
-                            it->second.push_back(title);
-                        }
-                        else {
-                            // not found, insert into map
-                            std::vector<Title> v;
-                            v.push_back(title);
-                            titles.emplace(uid, v);
-                        }
+        std::shared_ptr<const TitleInfo>& shared = infos[tid];
+        if (!shared) {
+            TitleCache::Entry& entry = current[tid];
+            if (control->cached) {
+                entry = std::move(cache.at(tid));
+                if (icons.find(tid) == icons.end() && entry.iconOffset != 0) {
+                    iconSources[tid] = {entry.iconOffset, entry.iconWidth, entry.iconHeight};
+                }
+            }
+            else {
+                entry = {control->version, control->name, control->author, 0, 0, 0, {}};
+                int w, h;
+                if (SDLH_DecodeImage(control->icon.data(), control->icon.size(), entry.pixels, &w, &h)) {
+                    entry.iconWidth  = w;
+                    entry.iconHeight = h;
+                    if (icons.find(tid) == icons.end()) {
+                        loadIcon(tid, entry.pixels, w, h);
                     }
                 }
-                nle = NULL;
+                // the JPEG is of no use once it is decoded
+                std::vector<u8>().swap(control->icon);
+                fetched++;
             }
+            shared = makeTitleInfo(tid, entry.name, entry.author);
+            backupScanQueue.push_back(shared);
+        }
+
+        Title title;
+        title.init(info.save_data_type, tid, uid, shared);
+        title.saveId(sid);
+
+        // load play statistics
+        PdmPlayStatistics stats;
+        res = pdmqryQueryPlayStatisticsByApplicationIdAndUserAccountId(tid, uid, false, &stats);
+        if (R_SUCCEEDED(res)) {
+            title.playTimeNanoseconds(stats.playtime);
+            title.lastPlayedTimestamp(stats.last_timestamp_user);
+        }
+
+        // check if the vector is already created
+        std::unordered_map<AccountUid, std::vector<Title>>::iterator it = loaded.find(uid);
+        if (it != loaded.end()) {
+            // found
+            it->second.push_back(title);
+        }
+        else {
+            // not found, insert into map
+            std::vector<Title> v;
+            v.push_back(title);
+            loaded.emplace(uid, v);
         }
     }
 
-    free(nsacd);
-    fsSaveDataInfoReaderClose(&reader);
+    // the new file moves every icon, the ones not drawn yet are read from their new place
+    const size_t dropped = cache.size() - (current.size() - fetched);
+    Logging::debug("Title cache: {} applications reused, {} fetched, {} dropped", current.size() - fetched, fetched, dropped);
+    if ((fetched > 0 || dropped > 0) && TitleCache::save(current)) {
+        for (const auto& [id, entry] : current) {
+            if (icons.find(id) == icons.end() && entry.iconOffset != 0) {
+                iconSources[id] = {entry.iconOffset, entry.iconWidth, entry.iconHeight};
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(titlesMutex);
+        titles = std::move(loaded);
+        titlesGeneration++;
+    }
 
     sortTitles();
+
+    // backups are listed on first use otherwise, which is what happens anyway if the thread can't be made
+    backupScanStop = false;
+    if (R_SUCCEEDED(threadCreate(&backupScanThread, backupScan, nullptr, nullptr, 0x8000, 0x3B, -2))) {
+        backupScanStarted = R_SUCCEEDED(threadStart(&backupScanThread));
+        if (!backupScanStarted) {
+            threadClose(&backupScanThread);
+        }
+    }
 }
 
 void sortTitles(void)
 {
+    std::lock_guard<std::mutex> lock(titlesMutex);
     for (auto& vect : titles) {
-        std::sort(vect.second.begin(), vect.second.end(), [](Title& l, Title& r) {
-            if (Configuration::getInstance().favorite(l.id()) != Configuration::getInstance().favorite(r.id())) {
-                return Configuration::getInstance().favorite(l.id());
+        std::vector<Title>& list = vect.second;
+
+        // one key per title, so comparing two titles neither looks up favorites nor copies names. the titles are
+        // then moved once into their final order instead of being swapped around by the sort
+        std::vector<SortKey> keys;
+        keys.reserve(list.size());
+        for (auto& title : list) {
+            keys.push_back(
+                {Configuration::getInstance().favorite(title.id()), title.lastPlayedTimestamp(), title.playTimeNanoseconds(), title.name()});
+        }
+
+        std::vector<size_t> order(list.size());
+        std::iota(order.begin(), order.end(), 0);
+        const sort_t mode = g_sortMode;
+        std::sort(order.begin(), order.end(), [&keys, mode](size_t li, size_t ri) {
+            const SortKey& l = keys[li];
+            const SortKey& r = keys[ri];
+            if (l.favorite != r.favorite) {
+                return l.favorite;
             }
-            switch (g_sortMode) {
+            switch (mode) {
                 case SORT_LAST_PLAYED:
-                    return l.lastPlayedTimestamp() > r.lastPlayedTimestamp();
+                    return l.lastPlayed > r.lastPlayed;
                 case SORT_PLAY_TIME:
-                    return l.playTimeNanoseconds() > r.playTimeNanoseconds();
+                    return l.playTime > r.playTime;
                 case SORT_ALPHA:
                 default:
-                    return l.name() < r.name();
+                    return l.name < r.name;
             }
         });
+
+        std::vector<Title> sorted;
+        sorted.reserve(list.size());
+        for (size_t i : order) {
+            sorted.push_back(std::move(list[i]));
+        }
+        list = std::move(sorted);
     }
+    titlesGeneration++;
 }
 
 void rotateSortMode(void)
@@ -302,30 +549,42 @@ void rotateSortMode(void)
 
 void getTitle(Title& dst, AccountUid uid, size_t i)
 {
+    std::lock_guard<std::mutex> lock(titlesMutex);
     std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-    if (it != titles.end() && i < getTitleCount(uid)) {
+    if (it != titles.end() && i < it->second.size()) {
         dst = it->second.at(i);
     }
 }
 
+u32 getTitlesGeneration(void)
+{
+    std::lock_guard<std::mutex> lock(titlesMutex);
+    return titlesGeneration;
+}
+
 size_t getTitleCount(AccountUid uid)
 {
+    std::lock_guard<std::mutex> lock(titlesMutex);
     std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
     return it != titles.end() ? it->second.size() : 0;
 }
 
 bool favorite(AccountUid uid, int i)
 {
+    std::lock_guard<std::mutex> lock(titlesMutex);
     std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
     return it != titles.end() ? Configuration::getInstance().favorite(it->second.at(i).id()) : false;
 }
 
 void refreshDirectories(u64 id)
 {
+    std::lock_guard<std::mutex> lock(titlesMutex);
     for (auto& pair : titles) {
         for (size_t i = 0; i < pair.second.size(); i++) {
+            // every user's title shares the same backup list
             if (pair.second.at(i).id() == id) {
                 pair.second.at(i).refreshDirectories();
+                return;
             }
         }
     }
@@ -333,6 +592,7 @@ void refreshDirectories(u64 id)
 
 SDL_Texture* smallIcon(AccountUid uid, size_t i)
 {
+    std::lock_guard<std::mutex> lock(titlesMutex);
     std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
     return it != titles.end() ? it->second.at(i).icon() : NULL;
 }
@@ -340,6 +600,7 @@ SDL_Texture* smallIcon(AccountUid uid, size_t i)
 std::unordered_map<std::string, std::string> getCompleteTitleList(void)
 {
     std::unordered_map<std::string, std::string> map;
+    std::lock_guard<std::mutex> lock(titlesMutex);
     for (const auto& pair : titles) {
         for (auto value : pair.second) {
             map.insert({StringUtils::format("0x%016llX", value.id()), value.name()});
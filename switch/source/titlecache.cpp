@@ -0,0 +1,226 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2026 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "titlecache.hpp"
+#include "logging.hpp"
+#include "trace.hpp"
+#include "xxhash.hpp"
+#include <cstdio>
+#include <memory>
+
+namespace {
+    constexpr const char* CACHE_PATH     = "sdmc:/switch/Checkpoint/titlecache";
+    constexpr const char* CACHE_TEMPPATH = "sdmc:/switch/Checkpoint/titlecache.tmp";
+    constexpr u32 CACHE_MAGIC            = 0x53544B43; // "CKTS"
+    constexpr u32 CACHE_VERSION          = 1;
+
+    struct CacheHeader {
+        u32 magic;
+        u32 version;
+        u32 entries;
+        u32 stringBytes;
+        u64 checksum;
+    };
+
+    struct CacheString {
+        u32 offset;
+        u32 length;
+    };
+
+    struct CacheEntry {
+        u64 id;
+        u64 iconOffset;
+        u32 version;
+        CacheString name;
+        CacheString author;
+        u16 iconWidth;
+        u16 iconHeight;
+    };
+
+    static_assert(sizeof(CacheHeader) == 24 && sizeof(CacheEntry) == 40, "title cache layout must not depend on the compiler");
+
+    u64 iconSize(u16 width, u16 height)
+    {
+        return (u64)width * height * 3;
+    }
+}
+
+/**
+ * TITLE CACHE, version 1
+ * header      CacheHeader, checksum is the XXH64 of the entries and strings
+ * entries     CacheEntry[entries]
+ * strings     char[stringBytes], names and authors, referenced by offset and length
+ * icons       RGB24 pixels of every icon, referenced by file offset. never read on load, an icon is only
+ *             read once it is drawn
+ */
+void TitleCache::load(std::unordered_map<u64, Entry>& entries)
+{
+    Trace::Span span("loadTitleCache");
+    entries.clear();
+
+    FILE* file = fopen(CACHE_PATH, "rb");
+    if (file == NULL) {
+        return;
+    }
+
+    CacheHeader header;
+    if (fread(&header, sizeof(CacheHeader), 1, file) != 1 || header.magic != CACHE_MAGIC || header.version != CACHE_VERSION) {
+        fclose(file);
+        Logging::warning("Title cache is unreadable or of another version, fetching all control data.");
+        return;
+    }
+
+    fseek(file, 0, SEEK_END);
+    const u64 fileSize = ftell(file);
+    fseek(file, sizeof(CacheHeader), SEEK_SET);
+
+    const u64 entriesSize = (u64)header.entries * sizeof(CacheEntry);
+    const u64 indexSize   = entriesSize + header.stringBytes;
+    if (sizeof(CacheHeader) + indexSize > fileSize) {
+        fclose(file);
+        Logging::warning("Title cache is truncated, fetching all control data.");
+        return;
+    }
+
+    // u64 storage keeps the entry table aligned, so it is used in place
+    std::unique_ptr<u64[]> buffer(new u64[(indexSize + 7) / 8]);
+    u8* data          = reinterpret_cast<u8*>(buffer.get());
+    const size_t read = fread(data, 1, indexSize, file);
+    fclose(file);
+    if (read != indexSize || XXH64::hash(data, indexSize) != header.checksum) {
+        Logging::warning("Title cache doesn't match its checksum, fetching all control data.");
+        return;
+    }
+
+    const CacheEntry* cached = reinterpret_cast<const CacheEntry*>(data);
+    const char* strings      = reinterpret_cast<const char*>(data + entriesSize);
+
+    auto inRange = [&header](const CacheString& str) { return (u64)str.offset + str.length <= header.stringBytes; };
+    for (u32 i = 0; i < header.entries; i++) {
+        const CacheEntry& entry = cached[i];
+        if (!inRange(entry.name) || !inRange(entry.author) ||
+            (entry.iconOffset != 0 && entry.iconOffset + iconSize(entry.iconWidth, entry.iconHeight) > fileSize)) {
+            Logging::warning("Title cache entry {} is out of bounds, fetching all control data.", i);
+            return;
+        }
+    }
+
+    entries.reserve(header.entries);
+    for (u32 i = 0; i < header.entries; i++) {
+        const CacheEntry& entry = cached[i];
+        entries[entry.id] = {entry.version, std::string(strings + entry.name.offset, entry.name.length),
+            std::string(strings + entry.author.offset, entry.author.length), entry.iconWidth, entry.iconHeight, entry.iconOffset, {}};
+    }
+}
+
+bool TitleCache::save(std::unordered_map<u64, Entry>& entries)
+{
+    Trace::Span span("saveTitleCache");
+
+    std::string strings;
+    auto addString = [&strings](const std::string& str) {
+        CacheString ret = {(u32)strings.size(), (u32)str.size()};
+        strings += str;
+        return ret;
+    };
+
+    std::vector<CacheEntry> cached;
+    cached.reserve(entries.size());
+    for (const auto& [id, entry] : entries) {
+        cached.push_back({id, 0, entry.version, addString(entry.name), addString(entry.author), entry.iconWidth, entry.iconHeight});
+    }
+
+    // icons follow the index in entry order, so their offsets are known before anything is written
+    u64 offset = sizeof(CacheHeader) + cached.size() * sizeof(CacheEntry) + strings.size();
+    for (auto& entry : cached) {
+        if (entry.iconWidth > 0 && entry.iconHeight > 0) {
+            entry.iconOffset = offset;
+            offset += iconSize(entry.iconWidth, entry.iconHeight);
+        }
+    }
+
+    XXH64 checksum;
+    checksum.update(cached.data(), cached.size() * sizeof(CacheEntry));
+    checksum.update(strings.data(), strings.size());
+    const CacheHeader header = {CACHE_MAGIC, CACHE_VERSION, (u32)cached.size(), (u32)strings.size(), checksum.digest()};
+
+    // written next to the old file, which the icons of reused entries are still copied out of
+    FILE* file = fopen(CACHE_TEMPPATH, "wb");
+    if (file == NULL) {
+        Logging::error("Failed to create the title cache.");
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(CacheHeader), 1, file) == 1;
+    ok      = ok && fwrite(cached.data(), sizeof(CacheEntry), cached.size(), file) == cached.size();
+    ok      = ok && fwrite(strings.data(), 1, strings.size(), file) == strings.size();
+
+    std::vector<u8> pixels;
+    for (const auto& record : cached) {
+        if (!ok || record.iconOffset == 0) {
+            continue;
+        }
+        const Entry& entry = entries.at(record.id);
+        const u64 size     = iconSize(record.iconWidth, record.iconHeight);
+        if (entry.pixels.size() == size) {
+            ok = fwrite(entry.pixels.data(), 1, size, file) == size;
+        }
+        else {
+            ok = readIcon(entry.iconOffset, record.iconWidth, record.iconHeight, pixels) && fwrite(pixels.data(), 1, size, file) == size;
+        }
+    }
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok) {
+        remove(CACHE_TEMPPATH);
+        Logging::error("Failed to write the title cache.");
+        return false;
+    }
+
+    remove(CACHE_PATH);
+    if (rename(CACHE_TEMPPATH, CACHE_PATH) != 0) {
+        Logging::error("Failed to replace the title cache.");
+        return false;
+    }
+
+    for (const auto& record : cached) {
+        Entry& entry     = entries.at(record.id);
+        entry.iconOffset = record.iconOffset;
+        std::vector<u8>().swap(entry.pixels);
+    }
+    return true;
+}
+
+bool TitleCache::readIcon(u64 offset, u16 width, u16 height, std::vector<u8>& pixels)
+{
+    FILE* file = fopen(CACHE_PATH, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    pixels.resize(iconSize(width, height));
+    const bool ok = fseek(file, offset, SEEK_SET) == 0 && fread(pixels.data(), 1, pixels.size(), file) == pixels.size();
+    fclose(file);
+    return ok;
+}
@@ -25,9 +25,12 @@
  */
 
 #include "util.hpp"
+#include "trace.hpp"
 
 void servicesExit(void)
 {
+    stopBackupScan();
+    Trace::exit();
     if (g_ftpAvailable)
         ftp_exit();
     Configuration::getInstance().cleanup();
@@ -48,7 +51,9 @@ Result servicesInit(void)
     io::createDirectory("sdmc:/switch");
     io::createDirectory("sdmc:/switch/Checkpoint");
     io::createDirectory("sdmc:/switch/Checkpoint/saves");
+    io::createDirectory("sdmc:/switch/Checkpoint/chunks");
     io::createDirectory("sdmc:/switch/Checkpoint/logs");
+    Trace::init();
 
     Logging::info("Starting Checkpoint loading...");
 